@@ -0,0 +1,54 @@
+#include <Arduino.h>
+/**
+ * Blinky Challenge with a cyclic executive
+ *
+ * Same two blink rates as main.cpp, but both toggles are jobs of one
+ * table-driven cyclic executive (25 ms minor frames) instead of two tasks.
+ * The second rate is 325 ms instead of 323 ms: with 1 ms frames the 500/323
+ * schedule would only repeat every 161.5 s.
+ */
+#include "cyclic_executive.hpp"
+
+// Use only core 1 for demo purposes
+#if CONFIG_FREERTOS_UNICORE
+static const BaseType_t app_cpu = 0;
+#else
+static const BaseType_t app_cpu = 1;
+#endif
+
+// Pins
+static const int led_pin = LED_BUILTIN;
+
+// Our jobs: toggle the LED, each at its own rate
+void toggleLED_1()
+{
+    digitalWrite(led_pin, !digitalRead(led_pin));
+}
+
+void toggleLED_2()
+{
+    digitalWrite(led_pin, !digitalRead(led_pin));
+}
+
+// Schedule: 25 ms frames, toggle every 500 ms and every 325 ms
+constexpr CyclicJob jobs[] = {
+    {toggleLED_1, 20, 0},
+    {toggleLED_2, 13, 0},
+};
+static CyclicExecutive<jobs, 2, 25> executive;
+
+void setup()
+{
+    // Configure pin
+    pinMode(led_pin, OUTPUT);
+
+    // One task runs both jobs, on absolute frame times
+    executive.begin("Executive", 1024, 1, app_cpu);
+}
+
+void loop()
+{
+    // Do nothing
+    // setup() and loop() run in their own task with priority 1 in core 1
+    // on ESP32
+}
@@ -0,0 +1,186 @@
+/**
+ * Table-driven cyclic executive
+ *
+ * Periodic jobs run one after the other from a single task instead of one
+ * task (and one stack) each. Time is cut into minor frames of MINOR_MS; a
+ * job with period P frames and offset O runs in every frame f with
+ * f % P == O. The schedule repeats every major frame (the least common
+ * multiple of the periods), and the table of which jobs run in which frame
+ * is built by the compiler from a constexpr job list:
+ *
+ *   void blink1();
+ *   void blink2();
+ *   constexpr CyclicJob jobs[] = {
+ *       {blink1, 20, 0}, // Every 20 frames
+ *       {blink2, 13, 0}, // Every 13 frames
+ *   };
+ *   static CyclicExecutive<jobs, 2, 25> executive; // 25 ms minor frames
+ *   executive.begin("Executive", 2048, 1, app_cpu);
+ *
+ * Frames start at absolute times (vTaskDelayUntil), so the schedule doesn't
+ * drift. Jobs run in table order within a frame and must not block. A frame
+ * whose jobs take longer than MINOR_MS is counted as an overrun; the next
+ * frame then starts late but the following ones catch up.
+ *
+ * Periods must divide the major frame into a table that fits (MAX_FRAMES):
+ * pick harmonic-ish periods (e.g. 500 and 325 ms rather than 500 and 323).
+ */
+#pragma once
+#include <Arduino.h>
+
+struct CyclicJob
+{
+    void (*fn)();
+    uint32_t period; // Minor frames
+    uint32_t offset; // First frame, 0 to period - 1
+};
+
+namespace cyclic
+{
+    constexpr uint32_t gcd(uint32_t a, uint32_t b)
+    {
+        return b == 0 ? a : gcd(b, a % b);
+    }
+
+    constexpr uint32_t lcm(uint32_t a, uint32_t b)
+    {
+        return a / gcd(a, b) * b;
+    }
+
+    // Major frame: lcm of the first n periods
+    constexpr uint32_t majorFrames(const CyclicJob *jobs, size_t n)
+    {
+        return n == 0 ? 1 : lcm(jobs[n - 1].period, majorFrames(jobs, n - 1));
+    }
+
+    // Bit i set if job i runs in frame
+    constexpr uint32_t frameMask(const CyclicJob *jobs, size_t n, uint32_t frame)
+    {
+        return n == 0 ? 0
+                      : frameMask(jobs, n - 1, frame) |
+                            (frame % jobs[n - 1].period == jobs[n - 1].offset ? 1UL << (n - 1) : 0);
+    }
+
+    constexpr bool validJobs(const CyclicJob *jobs, size_t n)
+    {
+        return n == 0 || (jobs[n - 1].period > 0 && jobs[n - 1].offset < jobs[n - 1].period &&
+                          validJobs(jobs, n - 1));
+    }
+
+    // 0, 1, ..., N - 1 as a parameter pack (no std::index_sequence in C++11)
+    template <uint32_t... Is>
+    struct Frames
+    {
+    };
+
+    template <uint32_t N, uint32_t... Is>
+    struct MakeFrames : MakeFrames<N - 1, N - 1, Is...>
+    {
+    };
+
+    template <uint32_t... Is>
+    struct MakeFrames<0, Is...>
+    {
+        typedef Frames<Is...> type;
+    };
+
+    template <const CyclicJob *JOBS, size_t NUM_JOBS, typename F>
+    struct ScheduleTable;
+
+    template <const CyclicJob *JOBS, size_t NUM_JOBS, uint32_t... Is>
+    struct ScheduleTable<JOBS, NUM_JOBS, Frames<Is...>>
+    {
+        static const uint32_t masks[sizeof...(Is)];
+    };
+
+    // Constant-initialized: lives in flash, nothing computed at boot
+    template <const CyclicJob *JOBS, size_t NUM_JOBS, uint32_t... Is>
+    const uint32_t ScheduleTable<JOBS, NUM_JOBS, Frames<Is...>>::masks[sizeof...(Is)] = {
+        frameMask(JOBS, NUM_JOBS, Is)...};
+}
+
+template <const CyclicJob *JOBS, size_t NUM_JOBS, uint32_t MINOR_MS>
+class CyclicExecutive
+{
+public:
+    enum
+    {
+        MAX_FRAMES = 512,
+    };
+
+    static constexpr uint32_t MAJOR_FRAMES = cyclic::majorFrames(JOBS, NUM_JOBS);
+
+    static_assert(NUM_JOBS <= 32, "one bit per job in a frame mask");
+    static_assert(cyclic::validJobs(JOBS, NUM_JOBS), "period must be > 0 and offset < period");
+    static_assert(MAJOR_FRAMES <= MAX_FRAMES, "major frame too long: make the periods harmonic");
+
+    typedef cyclic::ScheduleTable<JOBS, NUM_JOBS, typename cyclic::MakeFrames<MAJOR_FRAMES>::type> Table;
+
+    // Start the executive task
+    bool begin(const char *name, uint32_t stack_size, UBaseType_t priority, BaseType_t core)
+    {
+        return xTaskCreatePinnedToCore(executiveTask,
+                                       name,
+                                       stack_size,
+                                       this,
+                                       priority,
+                                       &task,
+                                       core) == pdPASS;
+    }
+
+    // Frames whose jobs took longer than a minor frame
+    uint32_t getOverruns() const
+    {
+        return overruns;
+    }
+
+    // Longest time the jobs of one frame took
+    uint32_t getMaxFrameUs() const
+    {
+        return max_frame_us;
+    }
+
+    TaskHandle_t getTask() const
+    {
+        return task;
+    }
+
+private:
+    static void executiveTask(void *parameters)
+    {
+        CyclicExecutive *executive = (CyclicExecutive *)parameters;
+        const TickType_t minor = pdMS_TO_TICKS(MINOR_MS);
+        TickType_t wake = xTaskGetTickCount();
+        uint32_t frame = 0;
+
+        while (1)
+        {
+            int64_t start = esp_timer_get_time();
+            uint32_t mask = Table::masks[frame];
+            for (size_t i = 0; mask != 0; i++, mask >>= 1)
+            {
+                if (mask & 1)
+                {
+                    JOBS[i].fn();
+                }
+            }
+
+            uint32_t busy = esp_timer_get_time() - start;
+            if (busy > executive->max_frame_us)
+            {
+                executive->max_frame_us = busy;
+            }
+            if (busy > MINOR_MS * 1000)
+            {
+                executive->overruns++;
+            }
+
+            frame = frame + 1 < MAJOR_FRAMES ? frame + 1 : 0;
+            vTaskDelayUntil(&wake, minor);
+        }
+    }
+
+    TaskHandle_t task = NULL;
+    volatile uint32_t overruns = 0;
+    volatile uint32_t max_frame_us = 0;
+};
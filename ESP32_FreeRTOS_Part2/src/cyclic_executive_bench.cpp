@@ -0,0 +1,201 @@
+#include <Arduino.h>
+/**
+ * Cyclic Executive vs One Task per Job
+ *
+ * Three periodic jobs, the two blink toggles and a 25 ms poll that does
+ * 2 ms of work (like a CLI reading input), run for 10 s in each mode:
+ *  - delay: one task per job with vTaskDelay(), like main.cpp
+ *  - delay until: one task per job with vTaskDelayUntil()
+ *  - cyclic: one cyclic executive task, 25 ms minor frames
+ * For each job, the histogram is how far each run is from its ideal time
+ * (first run + n * period): release jitter, plus drift for vTaskDelay().
+ * RAM is the heap used by the mode's tasks (stacks and task control blocks).
+ */
+#include "cyclic_executive.hpp"
+#include "latency_histogram.hpp"
+
+// Use only core 1 for demo purposes
+#if CONFIG_FREERTOS_UNICORE
+static const BaseType_t app_cpu = 0;
+#else
+static const BaseType_t app_cpu = 1;
+#endif
+
+// Settings
+static const uint32_t run_ms = 10000;
+static const uint32_t poll_work_us = 2000;
+
+enum
+{
+    TASK_STACK_SIZE = 2048,
+    NUM_JOBS = 3,
+};
+
+enum Mode
+{
+    DELAY,
+    DELAY_UNTIL,
+    CYCLIC,
+    NUM_MODES
+};
+
+static const char *const mode_names[NUM_MODES] = {"delay", "delay until", "cyclic"};
+
+// Release times of one job
+struct JobStats
+{
+    const char *name;
+    uint32_t period_ms;
+    uint32_t runs;
+    int64_t first_us;
+    LatencyHistogram offset; // |actual - ideal| in us
+};
+
+// Pins
+static const int led_pin = LED_BUILTIN;
+
+// Globals
+static JobStats stats[NUM_JOBS] = {
+    {"toggle 500", 500},
+    {"toggle 325", 325},
+    {"poll 25", 25},
+};
+
+//*****************************************************************************
+// Jobs
+
+static void recordRun(JobStats &job)
+{
+    int64_t now = esp_timer_get_time();
+    if (job.runs == 0)
+    {
+        job.first_us = now;
+    }
+    int64_t ideal = job.first_us + (int64_t)job.runs * job.period_ms * 1000;
+    job.offset.record(now > ideal ? now - ideal : ideal - now);
+    job.runs++;
+}
+
+void toggleLED_1()
+{
+    recordRun(stats[0]);
+    digitalWrite(led_pin, !digitalRead(led_pin));
+}
+
+void toggleLED_2()
+{
+    recordRun(stats[1]);
+    digitalWrite(led_pin, !digitalRead(led_pin));
+}
+
+void poll()
+{
+    recordRun(stats[2]);
+    int64_t start = esp_timer_get_time();
+    while (esp_timer_get_time() - start < poll_work_us)
+        ;
+}
+
+static void (*const job_fns[NUM_JOBS])() = {toggleLED_1, toggleLED_2, poll};
+
+constexpr CyclicJob jobs[] = {
+    {toggleLED_1, 20, 0},
+    {toggleLED_2, 13, 0},
+    {poll, 1, 0},
+};
+static CyclicExecutive<jobs, NUM_JOBS, 25> executive;
+
+//*****************************************************************************
+// Tasks (one per job)
+
+void delayTask(void *parameters)
+{
+    int n = (int)(uintptr_t)parameters;
+    while (1)
+    {
+        job_fns[n]();
+        vTaskDelay(stats[n].period_ms / portTICK_PERIOD_MS);
+    }
+}
+
+void delayUntilTask(void *parameters)
+{
+    int n = (int)(uintptr_t)parameters;
+    TickType_t wake = xTaskGetTickCount();
+    while (1)
+    {
+        job_fns[n]();
+        vTaskDelayUntil(&wake, stats[n].period_ms / portTICK_PERIOD_MS);
+    }
+}
+
+//*****************************************************************************
+// Main (runs as its own task with priority 1 on core 1)
+
+void setup()
+{
+    TaskHandle_t tasks[NUM_JOBS];
+
+    pinMode(led_pin, OUTPUT);
+    Serial.begin(115200);
+    delay(1000);
+    Serial.println();
+    Serial.println("---FreeRTOS Cyclic Executive Benchmark---");
+
+    // Above the jobs, so each run ends on time
+    vTaskPrioritySet(NULL, 2);
+
+    for (int m = 0; m < NUM_MODES; m++)
+    {
+        for (int n = 0; n < NUM_JOBS; n++)
+        {
+            stats[n].runs = 0;
+            stats[n].offset.reset();
+        }
+
+        size_t heap_before = xPortGetFreeHeapSize();
+        int num_tasks = 0;
+        if (m == CYCLIC)
+        {
+            executive.begin("Executive", TASK_STACK_SIZE, 1, app_cpu);
+            tasks[num_tasks++] = executive.getTask();
+        }
+        else
+        {
+            for (int n = 0; n < NUM_JOBS; n++)
+            {
+                xTaskCreatePinnedToCore(m == DELAY ? delayTask : delayUntilTask,
+                                        stats[n].name,
+                                        TASK_STACK_SIZE,
+                                        (void *)(uintptr_t)n,
+                                        1,
+                                        &tasks[num_tasks++],
+                                        app_cpu);
+            }
+        }
+        size_t ram = heap_before - xPortGetFreeHeapSize();
+
+        vTaskDelay(pdMS_TO_TICKS(run_ms));
+        for (int t = 0; t < num_tasks; t++)
+        {
+            vTaskDelete(tasks[t]);
+        }
+
+        Serial.printf("%s: %d task(s), %u bytes\r\n", mode_names[m], num_tasks, (unsigned)ram);
+        for (int n = 0; n < NUM_JOBS; n++)
+        {
+            stats[n].offset.print(stats[n].name);
+        }
+        if (m == CYCLIC)
+        {
+            Serial.printf("  frame overruns %u, longest frame %u us\r\n",
+                          (unsigned)executive.getOverruns(), (unsigned)executive.getMaxFrameUs());
+        }
+        vTaskDelay(pdMS_TO_TICKS(100)); // Let the idle task free the stacks
+    }
+}
+
+void loop()
+{
+    delay(10);
+}
@@ -2,13 +2,17 @@
 /**
  * Solution to 02 - Blinky Challenge
  *
- * Toggles LED at different rates using separate tasks.
+ * Toggles LED at different rates using separate tasks. The periods are kept
+ * on absolute wake times (PeriodicTask), so they don't drift. Each task's
+ * release jitter and overruns are printed every 10 s.
  *
  * Date: December 3, 2020
  * Author: Shawn Hymel
  * License: 0BSD
  */
 
+#include "periodic_task.hpp"
+
 // Use only core 1 for demo purposes
 #if CONFIG_FREERTOS_UNICORE
 static const BaseType_t app_cpu = 0;
@@ -17,33 +21,40 @@ static const BaseType_t app_cpu = 1;
 #endif
 
 // LED rates
-static const int rate_1 = 500; // ms
-static const int rate_2 = 323; // ms
+static const int rate_1 = 500;      // ms
+static const int rate_2 = 323;      // ms
+static const int report_ms = 10000; // Time between jitter reports
 
 // Pins
 static const int led_pin = LED_BUILTIN;
 
+// Globals
+static PeriodicTask blink_1;
+static PeriodicTask blink_2;
+
 // Our task: blink an LED at one rate
 void toggleLED_1(void *parameter)
 {
+    blink_1.begin(rate_1 / portTICK_PERIOD_MS);
     while (1)
     {
         digitalWrite(led_pin, HIGH);
-        vTaskDelay(rate_1 / portTICK_PERIOD_MS);
+        blink_1.wait();
         digitalWrite(led_pin, LOW);
-        vTaskDelay(rate_1 / portTICK_PERIOD_MS);
+        blink_1.wait();
     }
 }
 
 // Our task: blink an LED at another rate
 void toggleLED_2(void *parameter)
 {
+    blink_2.begin(rate_2 / portTICK_PERIOD_MS);
     while (1)
     {
         digitalWrite(led_pin, HIGH);
-        vTaskDelay(rate_2 / portTICK_PERIOD_MS);
+        blink_2.wait();
         digitalWrite(led_pin, LOW);
-        vTaskDelay(rate_2 / portTICK_PERIOD_MS);
+        blink_2.wait();
     }
 }
 
@@ -53,6 +64,9 @@ void setup()
     // Configure pin
     pinMode(led_pin, OUTPUT);
 
+    // Configure serial for the jitter reports
+    Serial.begin(115200);
+
     // Task to run forever
     xTaskCreatePinnedToCore( // Use xTaskCreate() in vanilla FreeRTOS
         toggleLED_1,         // Function to be called
@@ -79,7 +93,10 @@ void setup()
 
 void loop()
 {
-    // Do nothing
+    // Report how well the blink tasks keep their periods
     // setup() and loop() run in their own task with priority 1 in core 1
     // on ESP32
+    vTaskDelay(report_ms / portTICK_PERIOD_MS);
+    blink_1.print("Toggle 1 jitter");
+    blink_2.print("Toggle 2 jitter");
 }
\ No newline at end of file
@@ -0,0 +1,335 @@
+/**
+ * Wait-for graph deadlock monitor
+ *
+ * Tasks take mutexes through DeadlockMonitor::take(), which records which
+ * mutex each task is blocked on. A monitor task wakes up every
+ * period and follows, for each blocked task,
+ *   task -> mutex it waits for -> holder (xSemaphoreGetMutexHolder) -> ...
+ * A task that waits at most one mutex at a time gives at most one way out,
+ * so the walk is linear. Coming back to the start task is a deadlock: it is
+ * reported once per set of waits (tasks and mutexes in the cycle) and handed
+ * to the optional recovery hook, which may abortWait() one of the tasks so
+ * its take() returns false.
+ *
+ * take() only records a wait if it has to block and the monitor task is
+ * running: a free mutex, or a program that never calls begin(), costs one
+ * plain xSemaphoreTake().
+ *
+ * Only waits older than one period count, so a chain that is just moving
+ * isn't taken for a cycle. For production, begin() can limit how many blocked
+ * tasks one run examines (round robin), which bounds the monitor's work per
+ * wake-up whatever the number of tasks.
+ */
+#pragma once
+#include <Arduino.h>
+
+class DeadlockMonitor
+{
+public:
+    enum
+    {
+        MAX_TASKS = 16,   // Tasks blocked at the same time
+        MAX_MUTEXES = 32, // Named mutexes
+        MONITOR_STACK_SIZE = 3072,
+    };
+
+    // Called from the monitor task with the cycle, tasks[i] waiting for
+    // mutexes[i], which tasks[i + 1] (or tasks[0] for the last) holds
+    typedef void (*RecoveryHook)(const TaskHandle_t *tasks, const SemaphoreHandle_t *mutexes, int len);
+
+    // Start the monitor task. max_checked: blocked tasks examined per run
+    // (0 = all of them).
+    static bool begin(TickType_t period, UBaseType_t priority, BaseType_t core,
+                      int max_checked = 0, RecoveryHook hook = NULL)
+    {
+        State &state = get();
+        state.period = period;
+        state.max_checked = max_checked;
+        state.hook = hook;
+        state.running = xTaskCreatePinnedToCore(monitorTask,
+                                                "Deadlock monitor",
+                                                MONITOR_STACK_SIZE,
+                                                NULL,
+                                                priority,
+                                                NULL,
+                                                core) == pdPASS;
+        return state.running;
+    }
+
+    // Name a mutex for reports
+    static void watch(SemaphoreHandle_t mutex, const char *name)
+    {
+        State &state = get();
+        portENTER_CRITICAL(&state.lock);
+        if (state.num_names < MAX_MUTEXES)
+        {
+            state.mutexes[state.num_names] = mutex;
+            state.names[state.num_names] = name;
+            state.num_names++;
+        }
+        portEXIT_CRITICAL(&state.lock);
+    }
+
+    // xSemaphoreTake() that the monitor can see (and abort). Returns false on
+    // timeout or abortWait().
+    static bool take(SemaphoreHandle_t mutex, TickType_t timeout)
+    {
+        State &state = get();
+
+        // Nobody watching, or no need to wait: nothing to record
+        if (!state.running)
+        {
+            return xSemaphoreTake(mutex, timeout) == pdTRUE;
+        }
+        if (xSemaphoreTake(mutex, 0) == pdTRUE)
+        {
+            return true;
+        }
+        if (timeout == 0)
+        {
+            return false;
+        }
+
+        TaskHandle_t me = xTaskGetCurrentTaskHandle();
+
+        // Free slot: untracked (the take still works, the monitor is blind)
+        int slot = -1;
+        portENTER_CRITICAL(&state.lock);
+        for (int i = 0; i < MAX_TASKS; i++)
+        {
+            if (state.waits[i].task == NULL)
+            {
+                slot = i;
+                state.waits[i].task = me;
+                state.waits[i].mutex = mutex;
+                state.waits[i].since = xTaskGetTickCount();
+                state.waits[i].abort = false;
+                state.waits[i].reported = false;
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&state.lock);
+
+        // Block in slices so an abort is noticed
+        bool taken = false;
+        TickType_t start = xTaskGetTickCount();
+        while (1)
+        {
+            TickType_t step = ABORT_POLL;
+            if (timeout != portMAX_DELAY)
+            {
+                TickType_t waited = xTaskGetTickCount() - start;
+                step = waited < timeout ? std::min(step, timeout - waited) : 0;
+            }
+            if (xSemaphoreTake(mutex, step) == pdTRUE)
+            {
+                taken = true;
+                break;
+            }
+            if (step == 0 || (slot >= 0 && state.waits[slot].abort))
+            {
+                break;
+            }
+        }
+
+        if (slot >= 0)
+        {
+            portENTER_CRITICAL(&state.lock);
+            state.waits[slot].task = NULL;
+            portEXIT_CRITICAL(&state.lock);
+        }
+        return taken;
+    }
+
+    // Make task's current take() give up (from the recovery hook)
+    static void abortWait(TaskHandle_t task)
+    {
+        State &state = get();
+        portENTER_CRITICAL(&state.lock);
+        for (int i = 0; i < MAX_TASKS; i++)
+        {
+            if (state.waits[i].task == task)
+            {
+                state.waits[i].abort = true;
+            }
+        }
+        portEXIT_CRITICAL(&state.lock);
+    }
+
+    static uint32_t getDeadlocks()
+    {
+        return get().deadlocks;
+    }
+
+private:
+    enum
+    {
+        ABORT_POLL = pdMS_TO_TICKS(50),
+    };
+
+    struct Wait
+    {
+        TaskHandle_t task; // NULL = free slot
+        SemaphoreHandle_t mutex;
+        TickType_t since;
+        bool abort;
+        bool reported;     // Part of a cycle already reported
+    };
+
+    struct State
+    {
+        Wait waits[MAX_TASKS];
+        SemaphoreHandle_t mutexes[MAX_MUTEXES];
+        const char *names[MAX_MUTEXES];
+        int num_names;
+        TickType_t period;
+        int max_checked;
+        int next_start;    // Round robin start (bounded mode)
+        RecoveryHook hook;
+        volatile bool running; // Monitor task started
+        volatile uint32_t deadlocks;
+        portMUX_TYPE lock;
+    };
+
+    static State &get()
+    {
+        static State state = {{}, {}, {}, 0, 0, 0, 0, NULL, false, 0, portMUX_INITIALIZER_UNLOCKED};
+        return state;
+    }
+
+    static void monitorTask(void *parameters)
+    {
+        State &state = get();
+        while (1)
+        {
+            vTaskDelay(state.period);
+            check(state);
+        }
+    }
+
+    // Find the wait of task in the snapshot
+    static const Wait *findWait(const Wait *waits, TaskHandle_t task)
+    {
+        for (int i = 0; i < MAX_TASKS; i++)
+        {
+            if (waits[i].task == task)
+            {
+                return &waits[i];
+            }
+        }
+        return NULL;
+    }
+
+    static void check(State &state)
+    {
+        // Work on a copy so tasks aren't held up while we walk
+        Wait waits[MAX_TASKS];
+        portENTER_CRITICAL(&state.lock);
+        memcpy(waits, state.waits, sizeof(waits));
+        portEXIT_CRITICAL(&state.lock);
+
+        TickType_t now = xTaskGetTickCount();
+        int checked = 0;
+        for (int n = 0; n < MAX_TASKS; n++)
+        {
+            int i = (state.next_start + n) % MAX_TASKS;
+            const Wait &start = waits[i];
+            if (start.task == NULL || now - start.since < state.period)
+            {
+                continue;
+            }
+            if (state.max_checked > 0 && checked == state.max_checked)
+            {
+                state.next_start = i;
+                return;
+            }
+            checked++;
+
+            // Follow task -> mutex -> holder until we leave the blocked set or
+            // come back
+            TaskHandle_t tasks[MAX_TASKS];
+            SemaphoreHandle_t mutexes[MAX_TASKS];
+            int len = 0;
+            const Wait *wait = &start;
+            while (wait != NULL && len < MAX_TASKS && now - wait->since >= state.period)
+            {
+                tasks[len] = wait->task;
+                mutexes[len] = wait->mutex;
+                len++;
+                TaskHandle_t holder = xSemaphoreGetMutexHolder(wait->mutex);
+                if (holder == start.task)
+                {
+                    if (isNew(waits, tasks, len))
+                    {
+                        report(state, waits, tasks, mutexes, len);
+                    }
+                    break;
+                }
+                wait = findWait(waits, holder);
+            }
+        }
+        state.next_start = 0;
+    }
+
+    // A cycle is new if one of its waits hasn't been reported yet (a task
+    // that backed off and blocked again is in a new wait)
+    static bool isNew(const Wait *waits, const TaskHandle_t *tasks, int len)
+    {
+        for (int k = 0; k < len; k++)
+        {
+            const Wait *wait = findWait(waits, tasks[k]);
+            if (wait != NULL && !wait->reported)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static const char *nameOf(State &state, SemaphoreHandle_t mutex)
+    {
+        for (int i = 0; i < state.num_names; i++)
+        {
+            if (state.mutexes[i] == mutex)
+            {
+                return state.names[i];
+            }
+        }
+        return "(unnamed mutex)";
+    }
+
+    static void report(State &state, Wait *waits, TaskHandle_t *tasks, SemaphoreHandle_t *mutexes, int len)
+    {
+        // Mark the waits (in the copy too) so the cycle is reported once
+        portENTER_CRITICAL(&state.lock);
+        for (int i = 0; i < MAX_TASKS; i++)
+        {
+            for (int k = 0; k < len; k++)
+            {
+                if (state.waits[i].task == tasks[k] && state.waits[i].mutex == mutexes[k])
+                {
+                    state.waits[i].reported = true;
+                }
+                if (waits[i].task == tasks[k])
+                {
+                    waits[i].reported = true;
+                }
+            }
+        }
+        state.deadlocks++;
+        portEXIT_CRITICAL(&state.lock);
+
+        Serial.printf("Deadlock between %d tasks:\r\n", len);
+        for (int k = 0; k < len; k++)
+        {
+            Serial.printf("  %s waits for %s held by %s\r\n",
+                          pcTaskGetName(tasks[k]),
+                          nameOf(state, mutexes[k]),
+                          pcTaskGetName(tasks[(k + 1) % len]));
+        }
+        if (state.hook != NULL)
+        {
+            state.hook(tasks, mutexes, len);
+        }
+    }
+};
@@ -6,6 +6,7 @@
  * https://www.youtube.com/watch?v=hRsWi4HIENc
  */
 #include <Arduino.h>
+#include "task_launch.hpp"
 
 static const BaseType_t app_cpu = 1;
 enum
@@ -14,18 +15,13 @@ enum
     TASK_STACK_SIZE = 2048
 };
 
-static SemaphoreHandle_t bin_sem;              // wait for parameters to be read
 static SemaphoreHandle_t done_sem;             // notifies main task when done as counting semaphores starts at 0
 static SemaphoreHandle_t chopstick[NUM_TASKS]; // as mutexes took guard the shared resource (the noodle bowl)
 static SemaphoreHandle_t waiter_sem;           // the arbitrator
 
 // Tasks: the only task is eating
-void eat(void *parameters)
+void eat(int num) // num: the philosopher number/identifier
 {
-    int num = *(int *)parameters; // the philosopher number/identifier
-    // Increment semaphore count
-    xSemaphoreGive(bin_sem); // to signify the task creation done.
-
     // Ask the waiter/arbitrator for taking a pair of chopstick to eat
     xSemaphoreTake(waiter_sem, portMAX_DELAY);
     {
@@ -54,9 +50,8 @@ void eat(void *parameters)
     }
     xSemaphoreGive(waiter_sem);
 
-    // Notify main task and delete self
+    // Notify main task and return (the launcher deletes the task)
     xSemaphoreGive(done_sem); // increase the done_sem counting semaphore
-    vTaskDelete(NULL);
 }
 
 // Main (runs as its own task with priority 1 on core 1 - app_cpu)
@@ -70,7 +65,6 @@ void setup()
     Serial.println("---FreeRTOS Dining Philosophers Challenge---");
 
     // Create kernel objects before starting tasks
-    bin_sem = xSemaphoreCreateBinary();
     done_sem = xSemaphoreCreateCounting(NUM_TASKS, 0);
     waiter_sem = xSemaphoreCreateMutex();
 
@@ -83,14 +77,13 @@ void setup()
     for (int i = 0; i < NUM_TASKS; i++)
     {
         sprintf(task_name, "Philosopher %i", i);
-        xTaskCreatePinnedToCore(eat,
-                                task_name,
-                                TASK_STACK_SIZE,
-                                (void *)&i,
-                                1,
-                                NULL,
-                                app_cpu);
-        xSemaphoreTake(bin_sem, portMAX_DELAY); // ensure the task was created and run before creating next task
+        LAUNCH_TASK(eat,
+                    i, // copied at creation, no need to wait for the task to read it
+                    task_name,
+                    TASK_STACK_SIZE,
+                    1,
+                    NULL,
+                    app_cpu);
     }
 
     // Wait until all the philosophers are done
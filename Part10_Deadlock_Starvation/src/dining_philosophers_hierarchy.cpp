@@ -7,6 +7,8 @@
  * https://www.youtube.com/watch?v=hRsWi4HIENc
  */
 #include <Arduino.h>
+#include "task_launch.hpp"
+#include "lock_order.hpp"
 
 static const BaseType_t app_cpu = 1;
 enum
@@ -15,32 +17,29 @@ enum
     TASK_STACK_SIZE = 2048
 };
 
-static SemaphoreHandle_t bin_sem;              // wait for parameters to be read
 static SemaphoreHandle_t done_sem;             // notifies main task when done as counting semaphores starts at 0
-static SemaphoreHandle_t chopstick[NUM_TASKS]; // as mutexes took guard the shared resource (the noodle bowl)
+static OrderedMutex chopstick[NUM_TASKS];      // as mutexes took guard the shared resource (the noodle bowl)
+static char chopstick_name[NUM_TASKS][16];     // lock names for lock order reports
 
 // Tasks: the only task is eating
-void eat(void *parameters)
+void eat(int num) // num: the philosopher number/identifier
 {
-    int num = *(int *)parameters; // the philosopher number/identifier
     int first = num;
     int second = (num + 1) % NUM_TASKS;  // the order of chopstick taken
-    // increment semaphore count
-    xSemaphoreGive(bin_sem); // to signify the task creation done.
     // Make sure the lower value chopstick will be taken first
     if (first > second) 
     {
         std::swap(first, second);
     }
 
-    xSemaphoreTake(chopstick[first], portMAX_DELAY);
+    chopstick[first].take(portMAX_DELAY);
     Serial.printf("Philosopher %i took chopstick %i\r\n", num, first);
 
     // Add some delay to force deadlock
     delay(3);
 
     // Take right chopstick
-    xSemaphoreTake(chopstick[second], portMAX_DELAY);
+    chopstick[second].take(portMAX_DELAY);
     Serial.printf("Philosopher %i took chopstick %i\r\n", num, second);
 
     // Do some eating
@@ -48,16 +47,15 @@ void eat(void *parameters)
     vTaskDelay(pdMS_TO_TICKS(10));
 
     // Put down right chopstick
-    xSemaphoreGive(chopstick[second]);
+    chopstick[second].give();
     Serial.printf("Philosopher %i returned chopstick %i\r\n", num, second);
 
     // Put down left chopstick
-    xSemaphoreGive(chopstick[first]);
+    chopstick[first].give();
     Serial.printf("Philosopher %i returned chopstick %i\r\n", num, first);
 
-    // Notify main task and delete self
+    // Notify main task and return (the launcher deletes the task)
     xSemaphoreGive(done_sem); // increase the done_sem counting semaphore
-    vTaskDelete(NULL);
 }
 
 // Main (runs as its own task with priority 1 on core 1 - app_cpu)
@@ -71,25 +69,24 @@ void setup()
     Serial.println("---FreeRTOS Dining Philosophers Challenge---");
 
     // Create kernel objects before starting tasks
-    bin_sem = xSemaphoreCreateBinary();
     done_sem = xSemaphoreCreateCounting(NUM_TASKS, 0);
     for (int i = 0; i < NUM_TASKS; i++)
     {
-        chopstick[i] = xSemaphoreCreateMutex();
+        sprintf(chopstick_name[i], "chopstick %i", i);
+        chopstick[i].begin(chopstick_name[i]);
     }
 
     // Have the philosophers start eating
     for (int i = 0; i < NUM_TASKS; i++)
     {
         sprintf(task_name, "Philosopher %i", i);
-        xTaskCreatePinnedToCore(eat,
-                                task_name,
-                                TASK_STACK_SIZE,
-                                (void *)&i,
-                                1,
-                                NULL,
-                                app_cpu);
-        xSemaphoreTake(bin_sem, portMAX_DELAY); // ensure the task was created and run before creating next task
+        LAUNCH_TASK(eat,
+                    i, // copied at creation, no need to wait for the task to read it
+                    task_name,
+                    TASK_STACK_SIZE,
+                    1,
+                    NULL,
+                    app_cpu);
     }
 
     // Wait until all the philosophers are done
@@ -0,0 +1,91 @@
+/**
+ * ESP32 Dining Philosophers
+ *
+ * The classic "Dining Philosophers" problem in FreeRTOS form.
+ * Solution without an arbitrator: each philosopher takes both chopsticks in
+ * one MultiLock call, which can't deadlock, so neighbours that don't share a
+ * chopstick eat at the same time.
+ *
+ * https://www.youtube.com/watch?v=hRsWi4HIENc
+ */
+#include <Arduino.h>
+#include "task_launch.hpp"
+#include "multi_lock.hpp"
+
+static const BaseType_t app_cpu = 1;
+enum
+{
+    NUM_TASKS = 5, // number of tasks (philosophers)
+    TASK_STACK_SIZE = 2048
+};
+
+static SemaphoreHandle_t done_sem;             // notifies main task when done as counting semaphores starts at 0
+static SemaphoreHandle_t chopstick[NUM_TASKS]; // as mutexes took guard the shared resource (the noodle bowl)
+
+// Tasks: the only task is eating
+void eat(int num) // num: the philosopher number/identifier
+{
+    int left = num;
+    int right = (num + 1) % NUM_TASKS;
+
+    {
+        // Take both chopsticks, in whatever order can't deadlock
+        MultiLock chopsticks({chopstick[left], chopstick[right]}, MultiLock::TRY_BACKOFF);
+        Serial.printf("Philosopher %i took chopsticks %i and %i (%u retries)\r\n",
+                      num, left, right, chopsticks.getRetries());
+
+        // Do some eating
+        Serial.printf("Philoshoper %i is eating\r\n", num);
+        vTaskDelay(pdMS_TO_TICKS(10));
+    } // Put down both chopsticks
+
+    Serial.printf("Philosopher %i returned chopsticks %i and %i\r\n", num, left, right);
+
+    // Notify main task and return (the launcher deletes the task)
+    xSemaphoreGive(done_sem); // increase the done_sem counting semaphore
+}
+
+// Main (runs as its own task with priority 1 on core 1 - app_cpu)
+
+void setup()
+{
+    char task_name[20];
+    Serial.begin(115200);
+    delay(1000);
+    Serial.println();
+    Serial.println("---FreeRTOS Dining Philosophers Challenge---");
+
+    // Create kernel objects before starting tasks
+    done_sem = xSemaphoreCreateCounting(NUM_TASKS, 0);
+    for (int i = 0; i < NUM_TASKS; i++)
+    {
+        chopstick[i] = xSemaphoreCreateMutex();
+    }
+
+    // Have the philosophers start eating
+    for (int i = 0; i < NUM_TASKS; i++)
+    {
+        sprintf(task_name, "Philosopher %i", i);
+        LAUNCH_TASK(eat,
+                    i, // copied at creation, no need to wait for the task to read it
+                    task_name,
+                    TASK_STACK_SIZE,
+                    1,
+                    NULL,
+                    app_cpu);
+    }
+
+    // Wait until all the philosophers are done
+    for (int i = 0; i < NUM_TASKS; i++)
+    {
+        xSemaphoreTake(done_sem, portMAX_DELAY);
+    }
+
+    // Say that we made it through without deadlock
+    Serial.println("Done! No deadlock occurred!");
+}
+
+void loop()
+{
+    delay(10); // Give time to the Wokwi simulator UI
+}
@@ -0,0 +1,299 @@
+/**
+ * Runtime lock-order validator for FreeRTOS mutexes
+ *
+ * OrderedMutex wraps a mutex with a lock class (one per mutex by default).
+ * With -D LOCK_ORDER_CHECK, every take() first records "taken while holding"
+ * edges between classes. When a new edge closes a cycle in that graph, e.g.
+ *   chopstick 0 -> chopstick 1 -> ... -> chopstick 4 -> chopstick 0
+ * the order is reported right away, before the take blocks: the tasks don't
+ * have to actually deadlock for the bad order to show up. Each edge is
+ * checked once, so a cycle is reported the first time it appears. A take()
+ * that adds several edges records all of them but reports one cycle.
+ *
+ * Fixed tables, no allocation: up to 32 classes and 16 tasks holding locks
+ * at the same time. Without LOCK_ORDER_CHECK, take()/give() are plain
+ * xSemaphoreTake()/xSemaphoreGive().
+ *
+ * With -D DEADLOCK_MONITOR, take() goes through DeadlockMonitor so that a
+ * running monitor sees which task waits for which mutex.
+ */
+#pragma once
+#include <Arduino.h>
+#ifdef DEADLOCK_MONITOR
+#include "deadlock_monitor.hpp"
+#endif
+
+#ifdef LOCK_ORDER_CHECK
+
+class LockOrder
+{
+public:
+    enum
+    {
+        MAX_CLASSES = 32,
+        MAX_TASKS = 16,
+    };
+
+    // New lock class, -1 if the table is full
+    static int addClass(const char *name)
+    {
+        State &state = get();
+        int cls = -1;
+        portENTER_CRITICAL(&state.lock);
+        if (state.num_classes < MAX_CLASSES)
+        {
+            cls = state.num_classes++;
+            state.names[cls] = name;
+        }
+        portEXIT_CRITICAL(&state.lock);
+        return cls;
+    }
+
+    // Record that the calling task is about to take a lock of class cls and
+    // report it if that closes a cycle
+    static void willTake(int cls)
+    {
+        State &state = get();
+        TaskHandle_t me = xTaskGetCurrentTaskHandle();
+        int path[MAX_CLASSES];
+        int path_len = 0;
+        int held_cls = -1;
+
+        portENTER_CRITICAL(&state.lock);
+        uint32_t *held_set = slot(state, me, false);
+        uint32_t held = held_set != NULL ? *held_set : 0;
+        if (held & bit(cls))
+        {
+            // Non-recursive mutex taken twice: deadlocks on the spot
+            path[0] = cls;
+            path_len = 1;
+            held_cls = cls;
+        }
+        for (int a = 0; a < state.num_classes; a++)
+        {
+            if (!(held & bit(a)) || (state.after[a] & bit(cls)))
+            {
+                continue; // Not held, or edge a -> cls already known
+            }
+            state.after[a] |= bit(cls);
+            if (path_len == 0)
+            {
+                path_len = findPath(state, cls, a, path);
+                held_cls = a;
+            }
+        }
+        if (path_len > 0)
+        {
+            state.reports++;
+        }
+        portEXIT_CRITICAL(&state.lock);
+
+        if (path_len > 0)
+        {
+            report(state, me, cls, held_cls, path, path_len);
+        }
+    }
+
+    static void taken(int cls)
+    {
+        State &state = get();
+        portENTER_CRITICAL(&state.lock);
+        uint32_t *held = slot(state, xTaskGetCurrentTaskHandle(), true);
+        if (held != NULL)
+        {
+            *held |= bit(cls);
+        }
+        portEXIT_CRITICAL(&state.lock);
+    }
+
+    static void given(int cls)
+    {
+        State &state = get();
+        portENTER_CRITICAL(&state.lock);
+        uint32_t *held = slot(state, xTaskGetCurrentTaskHandle(), false);
+        if (held != NULL)
+        {
+            *held &= ~bit(cls);
+            if (*held == 0)
+            {
+                // Free the task's slot when it holds nothing
+                state.tasks[held - state.held] = NULL;
+            }
+        }
+        portEXIT_CRITICAL(&state.lock);
+    }
+
+    // Cycles reported so far
+    static uint32_t getReports()
+    {
+        return get().reports;
+    }
+
+private:
+    struct State
+    {
+        const char *names[MAX_CLASSES];
+        uint32_t after[MAX_CLASSES]; // after[a] bit b: b taken while a held
+        int num_classes;
+        TaskHandle_t tasks[MAX_TASKS]; // Tasks holding locks
+        uint32_t held[MAX_TASKS];      // Classes each task holds
+        volatile uint32_t reports;
+        portMUX_TYPE lock;
+    };
+
+    static State &get()
+    {
+        static State state = {{}, {}, 0, {}, {}, 0, portMUX_INITIALIZER_UNLOCKED};
+        return state;
+    }
+
+    static inline uint32_t bit(int cls)
+    {
+        return 1UL << cls;
+    }
+
+    // The task's held set, optionally claiming a free slot (lock held)
+    static uint32_t *slot(State &state, TaskHandle_t task, bool claim)
+    {
+        int free_slot = -1;
+        for (int i = 0; i < MAX_TASKS; i++)
+        {
+            if (state.tasks[i] == task)
+            {
+                return &state.held[i];
+            }
+            if (state.tasks[i] == NULL && free_slot < 0)
+            {
+                free_slot = i;
+            }
+        }
+        if (!claim || free_slot < 0)
+        {
+            return NULL;
+        }
+        state.tasks[free_slot] = task;
+        state.held[free_slot] = 0;
+        return &state.held[free_slot];
+    }
+
+    // Depth-first search for a path from -> ... -> to along known edges.
+    // Fills path (from first) and returns its length, 0 if none (lock held).
+    static int findPath(State &state, int from, int to, int *path)
+    {
+        uint32_t visited = bit(from);
+        int depth = 0;
+        int next[MAX_CLASSES]; // Next neighbour to try at each depth
+        path[0] = from;
+        next[0] = 0;
+        while (depth >= 0)
+        {
+            int node = path[depth];
+            if (node == to)
+            {
+                return depth + 1;
+            }
+            int n = next[depth];
+            while (n < state.num_classes && (!(state.after[node] & bit(n)) || (visited & bit(n))))
+            {
+                n++;
+            }
+            if (n == state.num_classes)
+            {
+                depth--;
+                continue;
+            }
+            next[depth] = n + 1;
+            visited |= bit(n);
+            depth++;
+            path[depth] = n;
+            next[depth] = 0;
+        }
+        return 0;
+    }
+
+    static void report(State &state, TaskHandle_t task, int cls, int held_cls, int *path, int path_len)
+    {
+        Serial.printf("Lock order: %s takes \"%s\" while holding \"%s\"",
+                      pcTaskGetName(task), state.names[cls], state.names[held_cls]);
+        if (path_len == 1)
+        {
+            Serial.println(" (already held: self deadlock)");
+            return;
+        }
+        Serial.print(", but earlier");
+        for (int i = 0; i < path_len; i++)
+        {
+            Serial.printf("%s\"%s\"", i == 0 ? " " : " -> ", state.names[path[i]]);
+        }
+        Serial.println(": potential deadlock");
+    }
+};
+
+#endif
+
+class OrderedMutex
+{
+public:
+    // Create the mutex (and its lock class, named for reports)
+    bool begin(const char *name)
+    {
+#ifdef LOCK_ORDER_CHECK
+        lock_class = LockOrder::addClass(name);
+#endif
+        handle = xSemaphoreCreateMutex();
+#ifdef DEADLOCK_MONITOR
+        DeadlockMonitor::watch(handle, name);
+#endif
+        return handle != NULL;
+    }
+
+    bool take(TickType_t timeout)
+    {
+#ifdef LOCK_ORDER_CHECK
+        if (lock_class >= 0)
+        {
+            LockOrder::willTake(lock_class);
+        }
+#endif
+#ifdef DEADLOCK_MONITOR
+        if (!DeadlockMonitor::take(handle, timeout))
+        {
+            return false;
+        }
+#else
+        if (xSemaphoreTake(handle, timeout) != pdTRUE)
+        {
+            return false;
+        }
+#endif
+#ifdef LOCK_ORDER_CHECK
+        if (lock_class >= 0)
+        {
+            LockOrder::taken(lock_class);
+        }
+#endif
+        return true;
+    }
+
+    void give()
+    {
+#ifdef LOCK_ORDER_CHECK
+        if (lock_class >= 0)
+        {
+            LockOrder::given(lock_class);
+        }
+#endif
+        xSemaphoreGive(handle);
+    }
+
+    SemaphoreHandle_t getHandle() const
+    {
+        return handle;
+    }
+
+private:
+    SemaphoreHandle_t handle = NULL;
+#ifdef LOCK_ORDER_CHECK
+    int lock_class = -1;
+#endif
+};
@@ -0,0 +1,110 @@
+/**
+ * Lock Order Validator Overhead Benchmark
+ *
+ * Average cost (CPU cycles) of an uncontended take/give pair, for a single
+ * lock and for two nested locks (the philosopher pattern):
+ *  - plain xSemaphoreTake/xSemaphoreGive
+ *  - OrderedMutex, which records the lock order when built with
+ *    -D LOCK_ORDER_CHECK (and is a plain mutex otherwise)
+ * 20 lock classes are registered so the graph isn't trivially small.
+ */
+#include <Arduino.h>
+#include "lock_order.hpp"
+
+// Settings
+static const uint32_t num_rounds = 20000;
+
+enum
+{
+    NUM_LOCKS = 20,
+};
+
+// Globals
+static SemaphoreHandle_t plain[NUM_LOCKS];
+static OrderedMutex ordered[NUM_LOCKS];
+static char lock_name[NUM_LOCKS][16];
+
+//*****************************************************************************
+// Main
+
+static void report(const char *name, uint32_t start, uint32_t end)
+{
+    Serial.printf("%-28s | %8.1f cycles/round\r\n", name, (float)(end - start) / num_rounds);
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    delay(1000); // for UART connection
+    Serial.println();
+    Serial.println("---Lock Order Validator Overhead---");
+#ifdef LOCK_ORDER_CHECK
+    Serial.println("LOCK_ORDER_CHECK on");
+#else
+    Serial.println("LOCK_ORDER_CHECK off");
+#endif
+
+    for (int i = 0; i < NUM_LOCKS; i++)
+    {
+        plain[i] = xSemaphoreCreateMutex();
+        sprintf(lock_name[i], "lock %i", i);
+        ordered[i].begin(lock_name[i]);
+    }
+
+    // Teach the validator a chain of orders first, as a real program would
+    for (int i = 0; i + 1 < NUM_LOCKS; i++)
+    {
+        ordered[i].take(portMAX_DELAY);
+        ordered[i + 1].take(portMAX_DELAY);
+        ordered[i + 1].give();
+        ordered[i].give();
+    }
+
+    uint32_t start = ESP.getCycleCount();
+    for (uint32_t n = 0; n < num_rounds; n++)
+    {
+        xSemaphoreTake(plain[n % NUM_LOCKS], portMAX_DELAY);
+        xSemaphoreGive(plain[n % NUM_LOCKS]);
+    }
+    report("plain, one lock", start, ESP.getCycleCount());
+
+    start = ESP.getCycleCount();
+    for (uint32_t n = 0; n < num_rounds; n++)
+    {
+        ordered[n % NUM_LOCKS].take(portMAX_DELAY);
+        ordered[n % NUM_LOCKS].give();
+    }
+    report("OrderedMutex, one lock", start, ESP.getCycleCount());
+
+    start = ESP.getCycleCount();
+    for (uint32_t n = 0; n < num_rounds; n++)
+    {
+        int first = n % (NUM_LOCKS - 1);
+        xSemaphoreTake(plain[first], portMAX_DELAY);
+        xSemaphoreTake(plain[first + 1], portMAX_DELAY);
+        xSemaphoreGive(plain[first + 1]);
+        xSemaphoreGive(plain[first]);
+    }
+    report("plain, two nested", start, ESP.getCycleCount());
+
+    start = ESP.getCycleCount();
+    for (uint32_t n = 0; n < num_rounds; n++)
+    {
+        int first = n % (NUM_LOCKS - 1);
+        ordered[first].take(portMAX_DELAY);
+        ordered[first + 1].take(portMAX_DELAY);
+        ordered[first + 1].give();
+        ordered[first].give();
+    }
+    report("OrderedMutex, two nested", start, ESP.getCycleCount());
+
+#ifdef LOCK_ORDER_CHECK
+    Serial.printf("Cycles reported: %u (expected 0)\r\n", LockOrder::getReports());
+#endif
+    Serial.println("Done!");
+}
+
+void loop()
+{
+    delay(10); // Give time to the Wokwi simulator UI
+}
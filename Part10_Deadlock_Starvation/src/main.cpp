@@ -2,10 +2,18 @@
  * ESP32 Dining Philosophers
  *
  * The classic "Dining Philosophers" problem in FreeRTOS form.
+ * Built with -D LOCK_ORDER_CHECK, the chopsticks report the circular
+ * acquisition order as soon as it appears, before the philosophers hang.
+ * Built with -D DEADLOCK_MONITOR, a monitor task reports the actual deadlock
+ * (who waits for which chopstick held by whom) and breaks it by making one
+ * philosopher put its left chopstick back down and try again. Both are on in
+ * the esp32doit-devkit-v1-debug environment.
  *
  * https://www.youtube.com/watch?v=hRsWi4HIENc
  */
 #include <Arduino.h>
+#include "task_launch.hpp"
+#include "lock_order.hpp"
 
 static const BaseType_t app_cpu = 1;
 enum
@@ -14,28 +22,36 @@ enum
     TASK_STACK_SIZE = 2048
 };
 
-static SemaphoreHandle_t bin_sem;              // wait for parameters to be read
+#ifdef DEADLOCK_MONITOR
+// Settings
+static const TickType_t monitor_period = pdMS_TO_TICKS(500); // Low rate: blocked for 500 ms+ counts
+static const UBaseType_t monitor_priority = 2;               // Above the philosophers
+#endif
+
 static SemaphoreHandle_t done_sem;             // notifies main task when done as counting semaphores starts at 0
-static SemaphoreHandle_t chopstick[NUM_TASKS]; // as mutexes took guard the shared resource (the noodle bowl)
+static OrderedMutex chopstick[NUM_TASKS];      // as mutexes took guard the shared resource (the noodle bowl)
+static char chopstick_name[NUM_TASKS][16];     // lock names for lock order reports
 
 // Tasks: the only task is eating
-void eat(void *parameters)
+void eat(int num) // num: the philosopher number/identifier
 {
-    int num; // the philosopher number/identifier
-
-    // Copy parameter and increment semaphore count
-    num = *(int *)parameters;
-    xSemaphoreGive(bin_sem); // to signify the task creation done.
-
     // Take left chopstick
-    xSemaphoreTake(chopstick[num], portMAX_DELAY);
+    chopstick[num].take(portMAX_DELAY);
     Serial.printf("Philosopher %i took chopstick %i\r\n", num, num);
 
     // Add some delay to force deadlock
     delay(2);
 
-    // Take right chopstick
-    xSemaphoreTake(chopstick[(num + 1) % NUM_TASKS], portMAX_DELAY);
+    // Take right chopstick. Only fails when the deadlock monitor picked us to
+    // back off: put the left one down and start over.
+    while (!chopstick[(num + 1) % NUM_TASKS].take(portMAX_DELAY))
+    {
+        chopstick[num].give();
+        Serial.printf("Philosopher %i returned chopstick %i to break the deadlock\r\n", num, num);
+        vTaskDelay(pdMS_TO_TICKS(10 * (num + 1)));
+        chopstick[num].take(portMAX_DELAY);
+        Serial.printf("Philosopher %i took chopstick %i\r\n", num, num);
+    }
     Serial.printf("Philosopher %i took chopstick %i\r\n", num, (num + 1) % NUM_TASKS);
 
     // Do some eating
@@ -43,18 +59,25 @@ void eat(void *parameters)
     vTaskDelay(pdMS_TO_TICKS(10));
 
     // Put down right chopstick
-    xSemaphoreGive(chopstick[(num + 1) % NUM_TASKS]);
+    chopstick[(num + 1) % NUM_TASKS].give();
     Serial.printf("Philosopher %i returned chopstick %i\r\n", num, (num + 1) % NUM_TASKS);
 
     // Put down left chopstick
-    xSemaphoreGive(chopstick[num]);
+    chopstick[num].give();
     Serial.printf("Philosopher %i returned chopstick %i\r\n", num, num);
 
-    // Notify main task and delete self
+    // Notify main task and return (the launcher deletes the task)
     xSemaphoreGive(done_sem); // increase the done_sem counting semaphore
-    vTaskDelete(NULL);
 }
 
+#ifdef DEADLOCK_MONITOR
+// Recovery hook (monitor task): the first philosopher in the cycle backs off
+void breakDeadlock(const TaskHandle_t *tasks, const SemaphoreHandle_t *mutexes, int len)
+{
+    DeadlockMonitor::abortWait(tasks[0]);
+}
+#endif
+
 // Main (runs as its own task with priority 1 on core 1 - app_cpu)
 
 void setup()
@@ -66,25 +89,28 @@ void setup()
     Serial.println("---FreeRTOS Dining Philosophers Challenge---");
 
     // Create kernel objects before starting tasks
-    bin_sem = xSemaphoreCreateBinary();
     done_sem = xSemaphoreCreateCounting(NUM_TASKS, 0);
     for (int i = 0; i < NUM_TASKS; i++)
     {
-        chopstick[i] = xSemaphoreCreateMutex();
+        sprintf(chopstick_name[i], "chopstick %i", i);
+        chopstick[i].begin(chopstick_name[i]);
     }
 
+#ifdef DEADLOCK_MONITOR
+    DeadlockMonitor::begin(monitor_period, monitor_priority, app_cpu, NUM_TASKS, breakDeadlock);
+#endif
+
     // Have the philosophers start eating
     for (int i = 0; i < NUM_TASKS; i++)
     {
         sprintf(task_name, "Philosopher %i", i);
-        xTaskCreatePinnedToCore(eat,
-                                task_name,
-                                TASK_STACK_SIZE,
-                                (void *)&i,
-                                1,
-                                NULL,
-                                app_cpu);
-        xSemaphoreTake(bin_sem, portMAX_DELAY); // ensure the task was created and run before creating next task
+        LAUNCH_TASK(eat,
+                    i, // copied at creation, no need to wait for the task to read it
+                    task_name,
+                    TASK_STACK_SIZE,
+                    1,
+                    NULL,
+                    app_cpu);
     }
 
     // Wait until all the philosophers are done
@@ -94,6 +120,13 @@ void setup()
     }
 
     // Say that we made it through without deadlock
+#ifdef DEADLOCK_MONITOR
+    if (DeadlockMonitor::getDeadlocks() > 0)
+    {
+        Serial.printf("Done! %u deadlock(s) detected and broken\r\n", (unsigned)DeadlockMonitor::getDeadlocks());
+        return;
+    }
+#endif
     Serial.println("Done! No deadlock occurred!");
 }
 
@@ -0,0 +1,122 @@
+/**
+ * Scoped acquisition of several FreeRTOS mutexes at once
+ *
+ *   {
+ *       MultiLock both({chopstick[left], chopstick[right]});
+ *       ... eat ...
+ *   } // given back here
+ *
+ * No global arbitrator and no lock order to keep in mind at the call site.
+ * Two deadlock-free ways to get the whole set:
+ *  - BY_ADDRESS: sort the handles by address and take them in that order.
+ *    Every caller uses the same global order, so no cycle can form.
+ *  - TRY_BACKOFF: block on one mutex, try the others without waiting. If one
+ *    is busy, give everything back, wait a random 0 to max_backoff ticks and
+ *    start again by blocking on the busy one. Never holds a mutex while
+ *    waiting for another, so nothing waits in a circle.
+ * Mutexes are given back in reverse order when the MultiLock goes out of
+ * scope.
+ */
+#pragma once
+#include <Arduino.h>
+#include <initializer_list>
+
+class MultiLock
+{
+public:
+    enum
+    {
+        MAX_LOCKS = 8,
+    };
+
+    enum Mode
+    {
+        BY_ADDRESS,
+        TRY_BACKOFF,
+    };
+
+    MultiLock(std::initializer_list<SemaphoreHandle_t> mutexes,
+              Mode mode = BY_ADDRESS,
+              TickType_t max_backoff = 2)
+    {
+        for (SemaphoreHandle_t mutex : mutexes)
+        {
+            if (count < MAX_LOCKS)
+            {
+                locks[count++] = mutex;
+            }
+        }
+        if (mode == BY_ADDRESS)
+        {
+            takeByAddress();
+        }
+        else
+        {
+            takeWithBackoff(max_backoff);
+        }
+    }
+
+    ~MultiLock()
+    {
+        for (int i = count - 1; i >= 0; i--)
+        {
+            xSemaphoreGive(locks[i]);
+        }
+    }
+
+    // Times the whole set was given back and tried again (TRY_BACKOFF)
+    uint32_t getRetries() const
+    {
+        return retries;
+    }
+
+private:
+    MultiLock(const MultiLock &) = delete;
+    MultiLock &operator=(const MultiLock &) = delete;
+
+    void takeByAddress()
+    {
+        std::sort(locks, locks + count);
+        for (int i = 0; i < count; i++)
+        {
+            xSemaphoreTake(locks[i], portMAX_DELAY);
+        }
+    }
+
+    void takeWithBackoff(TickType_t max_backoff)
+    {
+        int first = 0;
+        while (1)
+        {
+            xSemaphoreTake(locks[first], portMAX_DELAY);
+            int busy = -1;
+            int taken = 1;
+            for (; taken < count; taken++)
+            {
+                int i = (first + taken) % count;
+                if (xSemaphoreTake(locks[i], 0) != pdTRUE)
+                {
+                    busy = i;
+                    break;
+                }
+            }
+            if (busy < 0)
+            {
+                return;
+            }
+
+            // Give back what we have and wait for the busy one next time
+            for (int k = taken - 1; k >= 0; k--)
+            {
+                xSemaphoreGive(locks[(first + k) % count]);
+            }
+            retries++;
+            vTaskDelay(esp_random() % (max_backoff + 1));
+            first = busy;
+        }
+    }
+
+    SemaphoreHandle_t locks[MAX_LOCKS];
+    int count = 0;
+    uint32_t retries = 0;
+};
@@ -0,0 +1,490 @@
+/**
+ * Dining Philosophers Benchmark
+ *
+ * Runs N philosophers (5 to 128) that think, get hungry, pick up their two
+ * chopsticks, eat and put them down again, over and over, for each strategy:
+ *  - naive: left then right (main.cpp). Reported as deadlocked when no one
+ *    has eaten for a second.
+ *  - arbitrator: one waiter mutex held while picking up and eating
+ *    (dining_philosophers_arbitrator.cpp)
+ *  - hierarchy: lower numbered chopstick first
+ *    (dining_philosophers_hierarchy.cpp)
+ *  - Chandy/Misra: chopsticks are dirty after a meal and handed to a hungry
+ *    neighbour on request, clean ones are kept until eaten with
+ *  - MultiLock by address / with try-lock backoff: both chopsticks in one
+ *    scoped call (multi_lock.hpp), no pause in between
+ * on one core or spread over both, and reports:
+ *  - meals per second, average and maximum number of philosophers eating
+ *    at the same time
+ *  - fairness (Jain's index, 1.0 = perfectly even) of meals and of the
+ *    average wait for chopsticks, per philosopher
+ *  - average and longest wait from hungry to eating (starvation)
+ * Sizes that don't fit in the heap are reported and skipped. Each philosopher
+ * costs about 1.5 KB (stack, TCB, mutex), so N stops at 128 (~200 KB):
+ * 256 would need ~400 KB, more than the ESP32 heap has.
+ */
+#include <Arduino.h>
+#include <atomic>
+#include "multi_lock.hpp"
+
+static const BaseType_t app_cpu = 1;
+
+// Settings
+static const int table_sizes[] = {5, 16, 64, 128};
+static const uint32_t run_ms = 3000;                  // Per run
+static const TickType_t think_time = pdMS_TO_TICKS(5);
+static const TickType_t eat_time = pdMS_TO_TICKS(5);
+static const TickType_t grab_pause = pdMS_TO_TICKS(1); // Between chopsticks
+static const uint32_t stall_ms = 1000;                // No meals: deadlock
+
+enum
+{
+    PHILOSOPHER_STACK_SIZE = 1024,
+};
+
+enum Strategy
+{
+    NAIVE,
+    ARBITRATOR,
+    HIERARCHY,
+    CHANDY_MISRA,
+    SCOPED_ADDRESS,
+    SCOPED_BACKOFF,
+    NUM_STRATEGIES
+};
+
+static const char *const strategy_names[NUM_STRATEGIES] = {
+    "naive", "arbitrator", "hierarchy", "Chandy/Misra", "scoped addr", "scoped try"};
+
+struct Philosopher
+{
+    TaskHandle_t task;
+    volatile uint32_t meals;
+    uint64_t wait_us;     // Total hungry time
+    uint32_t max_wait_us;
+    volatile bool eating; // Chandy/Misra: keeps its chopsticks
+    volatile bool finished;
+};
+
+// Chandy/Misra chopstick, shared by philosophers k - 1 and k
+struct Fork
+{
+    int owner;
+    bool dirty;
+    bool requested; // The other philosopher wants it
+    portMUX_TYPE lock;
+};
+
+// Globals
+static Strategy strategy;
+static int num_philosophers;
+static Philosopher *philosophers = NULL;
+static SemaphoreHandle_t *chopsticks = NULL;
+static Fork *forks = NULL;
+static SemaphoreHandle_t waiter_sem = NULL;
+static volatile bool running = false;
+static std::atomic<int> eating_now(0);
+static std::atomic<int> max_eating(0);
+
+//*****************************************************************************
+// Functions that can be called from anywhere (in this file)
+
+static inline int leftOf(int num)
+{
+    return num;
+}
+
+static inline int rightOf(int num)
+{
+    return (num + 1) % num_philosophers;
+}
+
+// Chandy/Misra: the philosopher sharing fork with num
+static inline int neighbourOf(int fork, int num)
+{
+    return fork == num ? (num - 1 + num_philosophers) % num_philosophers : fork;
+}
+
+// Chandy/Misra: get both forks. Dirty forks of a neighbour that isn't eating
+// are taken (and cleaned), for the others a request is left and the holder
+// hands them over after its meal.
+static bool chandyMisraPickUp(int num)
+{
+    int fork_ids[2] = {std::min(leftOf(num), rightOf(num)), std::max(leftOf(num), rightOf(num))};
+    while (running)
+    {
+        bool have_all = true;
+        for (int f : fork_ids)
+        {
+            Fork &fork = forks[f];
+            portENTER_CRITICAL(&fork.lock);
+            if (fork.owner != num)
+            {
+                if (fork.dirty && !philosophers[fork.owner].eating)
+                {
+                    fork.owner = num;
+                    fork.dirty = false;
+                    fork.requested = false;
+                }
+                else
+                {
+                    fork.requested = true;
+                    have_all = false;
+                }
+            }
+            portEXIT_CRITICAL(&fork.lock);
+        }
+
+        if (have_all)
+        {
+            // A dirty fork may have been taken meanwhile: check both and
+            // start eating under both locks
+            portENTER_CRITICAL(&forks[fork_ids[0]].lock);
+            portENTER_CRITICAL(&forks[fork_ids[1]].lock);
+            bool ok = forks[fork_ids[0]].owner == num && forks[fork_ids[1]].owner == num;
+            philosophers[num].eating = ok;
+            portEXIT_CRITICAL(&forks[fork_ids[1]].lock);
+            portEXIT_CRITICAL(&forks[fork_ids[0]].lock);
+            if (ok)
+            {
+                return true;
+            }
+        }
+
+        // Wait for a neighbour to hand a fork over (or poll again)
+        ulTaskNotifyTake(pdTRUE, 1);
+    }
+    return false;
+}
+
+// Chandy/Misra: forks are dirty after eating; requested ones go to the
+// neighbour right away
+static void chandyMisraPutDown(int num)
+{
+    int fork_ids[2] = {leftOf(num), rightOf(num)};
+    for (int f : fork_ids)
+    {
+        Fork &fork = forks[f];
+        int hand_to = -1;
+        portENTER_CRITICAL(&fork.lock);
+        fork.dirty = true;
+        if (fork.requested)
+        {
+            hand_to = neighbourOf(f, num);
+            fork.owner = hand_to;
+            fork.dirty = false;
+            fork.requested = false;
+        }
+        portEXIT_CRITICAL(&fork.lock);
+        if (hand_to >= 0)
+        {
+            xTaskNotifyGive(philosophers[hand_to].task);
+        }
+    }
+    philosophers[num].eating = false;
+}
+
+static bool pickUp(int num)
+{
+    int first = leftOf(num);
+    int second = rightOf(num);
+    switch (strategy)
+    {
+    case ARBITRATOR:
+        xSemaphoreTake(waiter_sem, portMAX_DELAY);
+        break;
+    case HIERARCHY:
+        if (first > second)
+        {
+            std::swap(first, second);
+        }
+        break;
+    case CHANDY_MISRA:
+        return chandyMisraPickUp(num);
+    default:
+        break;
+    }
+    xSemaphoreTake(chopsticks[first], portMAX_DELAY);
+    vTaskDelay(grab_pause);
+    xSemaphoreTake(chopsticks[second], portMAX_DELAY);
+    return true;
+}
+
+static void putDown(int num)
+{
+    if (strategy == CHANDY_MISRA)
+    {
+        chandyMisraPutDown(num);
+        return;
+    }
+    xSemaphoreGive(chopsticks[rightOf(num)]);
+    xSemaphoreGive(chopsticks[leftOf(num)]);
+    if (strategy == ARBITRATOR)
+    {
+        xSemaphoreGive(waiter_sem);
+    }
+}
+
+// Jain's fairness index: 1.0 when all values are equal, 1/n when one has all
+static float fairness(const float *values, int n)
+{
+    float sum = 0.0;
+    float sum_sq = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        sum += values[i];
+        sum_sq += values[i] * values[i];
+    }
+    return sum_sq > 0.0f ? (sum * sum) / (n * sum_sq) : 1.0f;
+}
+
+// Account for the wait since hungry, then eat
+static void eat(Philosopher &me, int64_t hungry)
+{
+    uint32_t wait = (uint32_t)(esp_timer_get_time() - hungry);
+    me.wait_us += wait;
+    me.max_wait_us = std::max(me.max_wait_us, wait);
+
+    int eaters = ++eating_now;
+    int seen = max_eating.load();
+    while (eaters > seen && !max_eating.compare_exchange_weak(seen, eaters))
+    {
+    }
+    vTaskDelay(eat_time);
+    eating_now--;
+    me.meals++;
+}
+
+//*****************************************************************************
+// Tasks
+
+void philosopherTask(void *parameters)
+{
+    int num = (int)(intptr_t)parameters;
+    Philosopher &me = philosophers[num];
+
+    // Start together
+    while (!running)
+    {
+        vTaskDelay(1);
+    }
+
+    while (running)
+    {
+        // Think
+        vTaskDelay(think_time);
+
+        // Get hungry
+        int64_t hungry = esp_timer_get_time();
+        if (strategy == SCOPED_ADDRESS || strategy == SCOPED_BACKOFF)
+        {
+            MultiLock both({chopsticks[leftOf(num)], chopsticks[rightOf(num)]},
+                           strategy == SCOPED_ADDRESS ? MultiLock::BY_ADDRESS : MultiLock::TRY_BACKOFF);
+            eat(me, hungry);
+        }
+        else
+        {
+            if (!pickUp(num))
+            {
+                break;
+            }
+            eat(me, hungry);
+            putDown(num);
+        }
+    }
+
+    // Wait to be deleted with the rest of the table
+    me.finished = true;
+    vTaskSuspend(NULL);
+}
+
+//*****************************************************************************
+// Main
+
+static uint32_t totalMeals()
+{
+    uint32_t total = 0;
+    for (int i = 0; i < num_philosophers; i++)
+    {
+        total += philosophers[i].meals;
+    }
+    return total;
+}
+
+static void freeTable()
+{
+    for (int i = 0; i < num_philosophers; i++)
+    {
+        if (philosophers[i].task != NULL)
+        {
+            vTaskDelete(philosophers[i].task);
+        }
+        if (chopsticks[i] != NULL)
+        {
+            vSemaphoreDelete(chopsticks[i]);
+        }
+    }
+    if (waiter_sem != NULL)
+    {
+        vSemaphoreDelete(waiter_sem);
+        waiter_sem = NULL;
+    }
+    delete[] philosophers;
+    delete[] chopsticks;
+    delete[] forks;
+    num_philosophers = 0;
+    philosophers = NULL;
+    chopsticks = NULL;
+    forks = NULL;
+}
+
+// Set the table for n philosophers. False if out of memory.
+static bool setTable(int n, int cores)
+{
+    philosophers = new (std::nothrow) Philosopher[n]();
+    chopsticks = new (std::nothrow) SemaphoreHandle_t[n]();
+    forks = new (std::nothrow) Fork[n];
+    if (philosophers == NULL || chopsticks == NULL || forks == NULL)
+    {
+        return false; // freeTable() only deletes the arrays
+    }
+    num_philosophers = n;
+
+    waiter_sem = xSemaphoreCreateMutex();
+    bool ok = waiter_sem != NULL;
+    for (int i = 0; i < n; i++)
+    {
+        chopsticks[i] = xSemaphoreCreateMutex();
+        ok = ok && chopsticks[i] != NULL;
+
+        // Fork k is shared by philosophers k - 1 and k. The lower numbered
+        // one starts with it, dirty.
+        forks[i].owner = std::min(i, (i - 1 + n) % n);
+        forks[i].dirty = true;
+        forks[i].requested = false;
+        portMUX_INITIALIZE(&forks[i].lock);
+    }
+    for (int i = 0; i < n && ok; i++)
+    {
+        ok = xTaskCreatePinnedToCore(philosopherTask,
+                                     "Philosopher",
+                                     PHILOSOPHER_STACK_SIZE,
+                                     (void *)(intptr_t)i,
+                                     1,
+                                     &philosophers[i].task,
+                                     cores == 1 ? app_cpu : i % 2) == pdPASS;
+    }
+    return ok;
+}
+
+static void runBench(Strategy s, int n, int cores)
+{
+    strategy = s;
+    eating_now = 0;
+    max_eating = 0;
+    if (!setTable(n, cores))
+    {
+        Serial.printf("%-12s | %3d | %5d | out of memory\r\n", strategy_names[s], n, cores);
+        freeTable();
+        return;
+    }
+
+    // Let them eat, sampling how many eat at once
+    running = true;
+    uint32_t start = millis();
+    uint32_t last_progress = start;
+    uint32_t last_meals = 0;
+    uint32_t samples = 0;
+    uint32_t eaters_sum = 0;
+    bool deadlocked = false;
+    while (millis() - start < run_ms)
+    {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        samples++;
+        eaters_sum += eating_now;
+        uint32_t meals = totalMeals();
+        if (meals != last_meals)
+        {
+            last_meals = meals;
+            last_progress = millis();
+        }
+        else if (millis() - last_progress > stall_ms)
+        {
+            deadlocked = true;
+            break;
+        }
+    }
+    uint32_t elapsed = millis() - start;
+    running = false;
+
+    // Let everyone finish the meal in progress
+    uint32_t stop = millis();
+    for (int i = 0; i < n && millis() - stop < 2000; i++)
+    {
+        while (!philosophers[i].finished && millis() - stop < 2000)
+        {
+            vTaskDelay(1);
+        }
+    }
+
+    float *meals = new (std::nothrow) float[n];
+    float *waits = new (std::nothrow) float[n];
+    if (meals != NULL && waits != NULL)
+    {
+        uint64_t wait_us = 0;
+        uint32_t max_wait_us = 0;
+        for (int i = 0; i < n; i++)
+        {
+            Philosopher &p = philosophers[i];
+            meals[i] = p.meals;
+            waits[i] = p.meals ? (float)p.wait_us / p.meals : 0.0f;
+            wait_us += p.wait_us;
+            max_wait_us = std::max(max_wait_us, p.max_wait_us);
+        }
+        uint32_t total = totalMeals();
+        Serial.printf("%-12s | %3d | %5d | %7.1f | %8.1f / %3d | %9.3f | %9.3f | %11.2f | %11.1f | %s\r\n",
+                      strategy_names[s], n, cores,
+                      total * 1000.0f / elapsed,
+                      samples ? (float)eaters_sum / samples : 0.0f,
+                      max_eating.load(),
+                      fairness(meals, n),
+                      fairness(waits, n),
+                      total ? wait_us / 1000.0f / total : 0.0f,
+                      max_wait_us / 1000.0f,
+                      deadlocked ? "DEADLOCK" : "ok");
+    }
+    delete[] meals;
+    delete[] waits;
+    freeTable();
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    delay(1000);
+    Serial.println();
+    Serial.println("---FreeRTOS Dining Philosophers Benchmark---");
+    Serial.printf("think %u ms, eat %u ms, %u ms per run\r\n",
+                  think_time * portTICK_PERIOD_MS, eat_time * portTICK_PERIOD_MS, run_ms);
+
+    // Stay above the philosophers to sample them
+    vTaskPrioritySet(NULL, 2);
+
+    Serial.println("strategy     |   N | cores | meals/s | eaters avg/max | meal fair | wait fair | avg wait ms | max wait ms | result");
+    for (int cores = 1; cores <= 2; cores++)
+    {
+        for (int n : table_sizes)
+        {
+            for (int s = 0; s < NUM_STRATEGIES; s++)
+            {
+                runBench((Strategy)s, n, cores);
+            }
+        }
+    }
+    Serial.println("Done!");
+}
+
+void loop()
+{
+    delay(10); // Give time to the Wokwi simulator UI
+}
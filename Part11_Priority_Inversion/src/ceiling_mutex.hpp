@@ -0,0 +1,77 @@
+/**
+ * Immediate priority-ceiling mutex
+ *
+ * The ceiling is the priority of the highest priority task that ever takes
+ * the mutex. take() raises the caller to the ceiling *before* taking, and
+ * give() drops it back afterwards. While a task holds the mutex, no other
+ * user of it can run on that core, so:
+ *  - a high priority task blocks for at most one critical section, even when
+ *    it needs several resources (no chained blocking)
+ *  - medium priority tasks can't preempt the holder (no unbounded inversion)
+ *  - the holder isn't preempted just to have the waiter block on it, which
+ *    saves two context switches per contended take
+ * Unlike portENTER_CRITICAL(), interrupts and tasks above the ceiling keep
+ * running.
+ *
+ * The FreeRTOS mutex underneath is only there for tasks on the other core;
+ * on a single core it is never contended. Each mutex remembers the priority
+ * its holder had, so nested takes must be given back in reverse order.
+ */
+#pragma once
+#include <Arduino.h>
+
+class CeilingMutex
+{
+public:
+    // ceiling: highest priority of the tasks using this mutex
+    bool begin(UBaseType_t ceiling)
+    {
+        this->ceiling = ceiling;
+        handle = xSemaphoreCreateMutex();
+        return handle != NULL;
+    }
+
+    bool take(TickType_t timeout)
+    {
+        UBaseType_t priority = uxTaskPriorityGet(NULL);
+        if (priority < ceiling)
+        {
+            vTaskPrioritySet(NULL, ceiling);
+        }
+        if (xSemaphoreTake(handle, timeout) != pdTRUE)
+        {
+            if (priority < ceiling)
+            {
+                vTaskPrioritySet(NULL, priority);
+            }
+            return false;
+        }
+        holder_priority = priority;
+        return true;
+    }
+
+    void give()
+    {
+        UBaseType_t priority = holder_priority;
+        xSemaphoreGive(handle);
+        if (priority < ceiling)
+        {
+            vTaskPrioritySet(NULL, priority); // May switch to a waiting task
+        }
+    }
+
+    UBaseType_t getCeiling() const
+    {
+        return ceiling;
+    }
+
+    SemaphoreHandle_t getHandle() const
+    {
+        return handle;
+    }
+
+private:
+    SemaphoreHandle_t handle = NULL;
+    UBaseType_t ceiling = 0;
+    UBaseType_t holder_priority = 0;
+};
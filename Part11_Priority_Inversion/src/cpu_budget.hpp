@@ -0,0 +1,287 @@
+/**
+ * CPU budget enforcement
+ *
+ * A task is given a budget of ticks per period (a simple deferrable server).
+ * A FreeRTOS tick hook on each core charges every tick to the task running
+ * on that core. Once a task has used its budget, the hook wakes a supervisor
+ * task (highest priority) that throttles it, either:
+ *  - DEMOTE: drop it to a lower priority, so it only gets the CPU nobody
+ *    else wants, or
+ *  - SUSPEND: stop it until the next period.
+ * At the start of each period the supervisor restores the task and refills
+ * its budget. Tasks below a hog then wait at most period - budget for the
+ * CPU, instead of as long as the hog likes.
+ *
+ * Charging happens at tick resolution (the running task at each tick gets
+ * the whole tick), so budgets are in ticks and a task can overrun by up to
+ * one tick plus the supervisor's reaction time.
+ *
+ * Mutex holders:
+ *  - DEMOTE only changes the base priority. A task that inherited a higher
+ *    priority through a mutex keeps it until it gives the mutex back, then
+ *    drops to the demoted priority. The priority restored at the next period
+ *    is the one the task had when add() was called, so add() a task while
+ *    it isn't holding a mutex.
+ *  - SUSPEND would stop a holder along with every task waiting for its
+ *    mutex. A task running above its base priority (it holds a mutex that a
+ *    higher priority task waits for) isn't suspended; the supervisor tries
+ *    again every tick until it drops back or the period ends. A holder that
+ *    nobody waits for yet can't be told apart, so prefer DEMOTE for tasks
+ *    that hold mutexes for long.
+ */
+#pragma once
+#include <Arduino.h>
+#include <esp_freertos_hooks.h>
+
+class CpuBudget
+{
+public:
+    enum
+    {
+        MAX_TASKS = 8,
+        SUPERVISOR_STACK_SIZE = 2048,
+    };
+
+    enum Action
+    {
+        DEMOTE,
+        SUSPEND,
+    };
+
+    // Start the supervisor and install the tick hooks
+    static bool begin(UBaseType_t priority = configMAX_PRIORITIES - 1)
+    {
+        State &state = get();
+        if (xTaskCreatePinnedToCore(supervisorTask,
+                                    "CPU budget",
+                                    SUPERVISOR_STACK_SIZE,
+                                    NULL,
+                                    priority,
+                                    &state.supervisor,
+                                    tskNO_AFFINITY) != pdPASS)
+        {
+            return false;
+        }
+        for (int cpu = 0; cpu < portNUM_PROCESSORS; cpu++)
+        {
+            if (esp_register_freertos_tick_hook_for_cpu(tickHook, cpu) != ESP_OK)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Limit task to budget ticks every period ticks. demoted_priority is
+    // used with DEMOTE. The task's current priority is recorded as its base
+    // priority. Returns an id, -1 if the table is full.
+    static int add(TaskHandle_t task, TickType_t budget, TickType_t period,
+                   Action action, UBaseType_t demoted_priority = 0)
+    {
+        State &state = get();
+        UBaseType_t priority = uxTaskPriorityGet(task);
+        int id = -1;
+        portENTER_CRITICAL(&state.lock);
+        for (int i = 0; i < MAX_TASKS; i++)
+        {
+            Entry &entry = state.entries[i];
+            if (entry.task == NULL)
+            {
+                entry.task = task;
+                entry.budget = budget;
+                entry.period = period;
+                entry.action = action;
+                entry.demoted_priority = demoted_priority;
+                entry.priority = priority;
+                entry.used = 0;
+                entry.next_release = xTaskGetTickCount() + period;
+                entry.overrun = false;
+                entry.throttled = false;
+                entry.overruns = 0;
+                id = i;
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&state.lock);
+        xTaskNotifyGive(state.supervisor); // New release time to wait for
+        return id;
+    }
+
+    // Stop enforcing (and restore the task if it is throttled)
+    static void remove(int id)
+    {
+        State &state = get();
+        Entry &entry = state.entries[id];
+        portENTER_CRITICAL(&state.lock);
+        bool throttled = entry.throttled;
+        entry.throttled = false;
+        portEXIT_CRITICAL(&state.lock);
+        if (throttled)
+        {
+            restore(entry);
+        }
+        portENTER_CRITICAL(&state.lock);
+        entry.task = NULL;
+        portEXIT_CRITICAL(&state.lock);
+    }
+
+    // Periods in which the task ran out of budget
+    static uint32_t getOverruns(int id)
+    {
+        return get().entries[id].overruns;
+    }
+
+private:
+    struct Entry
+    {
+        TaskHandle_t task; // NULL = free
+        TickType_t budget;
+        TickType_t period;
+        Action action;
+        UBaseType_t demoted_priority;
+        UBaseType_t priority; // Base priority, recorded by add()
+        volatile TickType_t used;
+        TickType_t next_release;
+        volatile bool overrun; // Set by the tick hook, handled by the supervisor
+        bool throttled;
+        volatile uint32_t overruns;
+    };
+
+    struct State
+    {
+        Entry entries[MAX_TASKS];
+        TaskHandle_t supervisor;
+        portMUX_TYPE lock;
+    };
+
+    static State &get()
+    {
+        static State state = {{}, NULL, portMUX_INITIALIZER_UNLOCKED};
+        return state;
+    }
+
+    static void IRAM_ATTR tickHook()
+    {
+        State &state = get();
+        TaskHandle_t running = xTaskGetCurrentTaskHandleForCPU(xPortGetCoreID());
+        bool wake = false;
+
+        portENTER_CRITICAL_ISR(&state.lock);
+        for (int i = 0; i < MAX_TASKS; i++)
+        {
+            Entry &entry = state.entries[i];
+            if (entry.task != running || running == NULL)
+            {
+                continue;
+            }
+            entry.used++;
+            if (entry.used >= entry.budget && !entry.overrun && !entry.throttled)
+            {
+                entry.overrun = true;
+                entry.overruns++;
+                wake = true;
+            }
+        }
+        portEXIT_CRITICAL_ISR(&state.lock);
+
+        // The supervisor runs as soon as the tick interrupt returns
+        if (wake)
+        {
+            BaseType_t task_woken = pdFALSE;
+            vTaskNotifyGiveFromISR(state.supervisor, &task_woken);
+            if (task_woken)
+            {
+                portYIELD_FROM_ISR();
+            }
+        }
+    }
+
+    // Returns false if the task can't be throttled right now
+    static bool throttle(Entry &entry)
+    {
+        if (entry.action == DEMOTE)
+        {
+            // Sets the base priority: an inherited priority is kept until
+            // the mutex is given back
+            vTaskPrioritySet(entry.task, entry.demoted_priority);
+        }
+        else if (uxTaskPriorityGet(entry.task) > entry.priority)
+        {
+            // Inherited: it holds a mutex a higher priority task waits for
+            return false;
+        }
+        else
+        {
+            vTaskSuspend(entry.task);
+        }
+        return true;
+    }
+
+    static void restore(Entry &entry)
+    {
+        if (entry.action == DEMOTE)
+        {
+            vTaskPrioritySet(entry.task, entry.priority);
+        }
+        else
+        {
+            vTaskResume(entry.task);
+        }
+    }
+
+    static void supervisorTask(void *parameters)
+    {
+        State &state = get();
+        TickType_t wait = portMAX_DELAY;
+        while (1)
+        {
+            ulTaskNotifyTake(pdTRUE, wait);
+            TickType_t now = xTaskGetTickCount();
+            wait = portMAX_DELAY;
+            for (int i = 0; i < MAX_TASKS; i++)
+            {
+                Entry &entry = state.entries[i];
+                if (entry.task == NULL)
+                {
+                    continue;
+                }
+
+                // Over budget: throttle until the next period
+                portENTER_CRITICAL(&state.lock);
+                bool overrun = entry.overrun && !entry.throttled;
+                if (overrun)
+                {
+                    entry.throttled = true;
+                }
+                portEXIT_CRITICAL(&state.lock);
+                if (overrun && !throttle(entry))
+                {
+                    portENTER_CRITICAL(&state.lock);
+                    entry.throttled = false;
+                    portEXIT_CRITICAL(&state.lock);
+                    wait = 1; // Try again next tick
+                }
+
+                // New period: refill and restore
+                if ((TickType_t)(now - entry.next_release) < portMAX_DELAY / 2)
+                {
+                    portENTER_CRITICAL(&state.lock);
+                    bool throttled = entry.throttled;
+                    entry.used = 0;
+                    entry.overrun = false;
+                    entry.throttled = false;
+                    while ((TickType_t)(now - entry.next_release) < portMAX_DELAY / 2)
+                    {
+                        entry.next_release += entry.period;
+                    }
+                    portEXIT_CRITICAL(&state.lock);
+                    if (throttled)
+                    {
+                        restore(entry);
+                    }
+                }
+                wait = std::min(wait, (TickType_t)(entry.next_release - now));
+            }
+        }
+    }
+};
@@ -0,0 +1,135 @@
+/**
+ * ESP32 CPU Budget Demo
+ *
+ * Task M hogs the CPU (busy loop, never blocks) above Task L, which wants to
+ * run every 20 ms. Each phase runs for a few seconds and reports how late
+ * Task L woke up:
+ *  - no budget: Task L only runs when Task M is done with its 5 s of work
+ *  - demote: Task M gets 30 ms per 100 ms at its priority, then drops below
+ *    Task L until the next period
+ *  - suspend: Task M is suspended once it used its 30 ms
+ * With a budget, Task L is never more than about 100 - 30 = 70 ms late.
+ */
+#include <Arduino.h>
+#include "cpu_budget.hpp"
+#include "latency_histogram.hpp"
+
+static const BaseType_t app_cpu = 1;
+
+// Settings
+static const TickType_t low_period = pdMS_TO_TICKS(20);   // Task L wake-up
+static const TickType_t med_wait = pdMS_TO_TICKS(5000);   // Task M work per burst
+static const TickType_t budget = pdMS_TO_TICKS(30);       // Task M CPU per period
+static const TickType_t budget_period = pdMS_TO_TICKS(100);
+static const uint32_t phase_ms = 6000;
+
+enum
+{
+    TASK_STACK_SIZE = 2048,
+};
+
+enum Phase
+{
+    NO_BUDGET,
+    DEMOTE,
+    SUSPEND,
+    NUM_PHASES
+};
+
+static const char *const phase_names[NUM_PHASES] = {"no budget", "demote", "suspend"};
+
+// Globals
+static LatencyHistogram low_lateness; // Task L wake-up lateness (ms)
+
+//*****************************************************************************
+// Tasks
+
+// Task L (low priority): periodic, records how late it runs
+void doTaskL(void *parameters)
+{
+    TickType_t wake = xTaskGetTickCount();
+    while (1)
+    {
+        vTaskDelayUntil(&wake, low_period);
+        low_lateness.record((xTaskGetTickCount() - wake) * portTICK_PERIOD_MS);
+    }
+}
+
+// Task M (medium priority): hogs the processor in long bursts
+void doTaskM(void *parameters)
+{
+    TickType_t timestamp;
+    while (1)
+    {
+        timestamp = xTaskGetTickCount();
+        while (xTaskGetTickCount() - timestamp < med_wait)
+            ;
+        vTaskDelay(pdMS_TO_TICKS(500));
+    }
+}
+
+//*****************************************************************************
+// Main (runs as its own task with priority 1 on core 1)
+
+void setup()
+{
+    TaskHandle_t task_l;
+    TaskHandle_t task_m;
+
+    Serial.begin(115200);
+    delay(1000);
+    Serial.println();
+    Serial.println("---FreeRTOS CPU Budget Demo---");
+    Serial.printf("Task M: %u ms budget every %u ms\r\n",
+                  (unsigned)(budget * portTICK_PERIOD_MS),
+                  (unsigned)(budget_period * portTICK_PERIOD_MS));
+
+    CpuBudget::begin();
+    xTaskCreatePinnedToCore(doTaskL,
+                            "Task L",
+                            TASK_STACK_SIZE,
+                            NULL,
+                            2,
+                            &task_l,
+                            app_cpu);
+
+    for (int p = 0; p < NUM_PHASES; p++)
+    {
+        xTaskCreatePinnedToCore(doTaskM,
+                                "Task M",
+                                TASK_STACK_SIZE,
+                                NULL,
+                                3,
+                                &task_m,
+                                app_cpu);
+        int id = -1;
+        if (p == DEMOTE)
+        {
+            id = CpuBudget::add(task_m, budget, budget_period, CpuBudget::DEMOTE, 1);
+        }
+        else if (p == SUSPEND)
+        {
+            id = CpuBudget::add(task_m, budget, budget_period, CpuBudget::SUSPEND);
+        }
+        low_lateness.reset();
+
+        // Task M also starves this task, so the phase may end late
+        vTaskDelay(pdMS_TO_TICKS(phase_ms));
+
+        uint32_t overruns = 0;
+        if (id >= 0)
+        {
+            overruns = CpuBudget::getOverruns(id);
+            CpuBudget::remove(id);
+        }
+        vTaskDelete(task_m);
+        low_lateness.print(phase_names[p], "ms");
+        Serial.printf("  Task M throttled %u times\r\n", (unsigned)overruns);
+    }
+    vTaskDelete(task_l);
+}
+
+void loop()
+{
+    delay(10); // Give Wokwi simulator UI time
+}
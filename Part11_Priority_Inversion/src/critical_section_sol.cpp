@@ -1,9 +1,12 @@
 /**
  * ESP32 unbounded Priority Inversion preventation using critical section
  *
+ * Type "stats" for each task's lock wait and hold times (p50/p99/max in
+ * CPU cycles), "reset" to start over.
  */
 
 #include <Arduino.h>
+#include "lock_stats.hpp"
 
 static const BaseType_t app_cpu = 1;
 
@@ -11,7 +14,7 @@ static const TickType_t cs_wait = 250;   // Time spent in critical section (ms)
 static const TickType_t med_wait = 5000; // Time medium task spends working (ms)
 
 // static SemaphoreHandle_t lock; Using spinlock/critical-section instead of a mutex lock
-static portMUX_TYPE spinlock = portMUX_INITIALIZER_UNLOCKED; // Spinlock
+static ProfiledLock<SpinLock> spinlock; // Spinlock, wait/hold times per task
 
 static inline TickType_t getTimestamp()
 {
@@ -21,27 +24,20 @@ static inline TickType_t getTimestamp()
 // Task L (low priority)
 void doTaskL(void *parameters)
 {
-    TickType_t start_time, stop_time, timestamp;
+    TickType_t timestamp;
     while (1)
     {
         // Take lock
         Serial.println("Task L trying to take lock ...");
-        start_time = getTimestamp();
         // xSemaphoreTake(lock, portMAX_DELAY);
-        portENTER_CRITICAL(&spinlock);
-
-        // Say how long we spend waiting for a lock
-        stop_time = getTimestamp();
+        spinlock.take(portMAX_DELAY); // Wait time goes to the lock's histogram
 
         // Hog the processor for a while doing nothing (don't yeild)
         timestamp = getTimestamp();
         while (getTimestamp() - timestamp < cs_wait)
             ;
-        portEXIT_CRITICAL(&spinlock);
+        spinlock.give();
 
-        Serial.print("Task L got lock. Spent ");
-        Serial.print(stop_time - start_time);
-        Serial.println(" ms waiting for lock. Doing some work ...");
         Serial.println("Task L released the lock.");
 
         // Go to sleep
@@ -69,17 +65,13 @@ void doTaskM(void *parameters)
 // Task H (high priority)
 void doTaskH(void *parameters)
 {
-    TickType_t timestamp, start_time, stop_time;
+    TickType_t timestamp;
     while (1)
     {
         // Take lock
         Serial.println("Task H trying to take lock ...");
-        start_time = getTimestamp();
         // xSemaphoreTake(lock, portMAX_DELAY);
-        portENTER_CRITICAL(&spinlock);
-
-        // Say how long we spend waiting for the lock
-        stop_time = getTimestamp();
+        spinlock.take(portMAX_DELAY); // Wait time goes to the lock's histogram
 
         // Hog the processor for a while
         timestamp = getTimestamp();
@@ -88,10 +80,7 @@ void doTaskH(void *parameters)
 
         // Release lock
         // xSemaphoreGive(lock);
-        portEXIT_CRITICAL(&spinlock);
-        Serial.print("Task H got lock. Spent ");
-        Serial.print(start_time - stop_time);
-        Serial.println(" ms waiting for lock ...");
+        spinlock.give();
         Serial.println("Task H released lock.");
 
         // Go to sleep
@@ -106,6 +95,8 @@ void setup()
     Serial.println();
     Serial.println("---FreeRTOS Priority Inversion: Critical Section Solution---");
 
+    spinlock.begin("spinlock");
+
     // The order of starting the tasks matters to force priority inversion
     xTaskCreatePinnedToCore(doTaskL,
                             "Task L",
@@ -137,5 +128,7 @@ void setup()
 
 void loop()
 {
+    // "stats" prints the lock histograms, "reset" clears them
+    LockStats::pollCommand();
     delay(10); // Give Wokwi simulator UI time
 }
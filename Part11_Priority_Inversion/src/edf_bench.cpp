@@ -0,0 +1,225 @@
+/**
+ * EDF vs Fixed Priority Benchmark
+ *
+ * Runs periodic task sets close to 100% CPU on one core, first with rate
+ * monotonic fixed priorities (TaskSet), then with the EDF layer
+ * (EdfScheduler), and counts jobs and deadline misses (deadline = period):
+ *  - "blink": the two Part2 blink periods, 500 ms and 323 ms, 94% busy
+ *  - "pair": 50 ms / 70 ms, 97% busy
+ *  - "three": 40 / 60 / 100 ms, 98% busy
+ * All three fail response-time analysis with rate monotonic priorities, so
+ * the longer period task misses deadlines, while EDF keeps every deadline
+ * as long as the total stays under 100% (plus its own overhead).
+ * Fixed priority misses are responses longer than the period (in us). EDF
+ * misses are the jobs EdfScheduler::complete() reports late (in ticks), and
+ * "sched" is the scheduler's own count, EdfScheduler::getMisses().
+ */
+#include <Arduino.h>
+#include "task_set.hpp"
+#include "edf_scheduler.hpp"
+
+static const BaseType_t app_cpu = 1;
+
+// Settings
+static const uint32_t run_ms = 5000;   // Per set and scheduler
+static const UBaseType_t band_low = 2; // Lowest priority of the bench tasks
+
+enum
+{
+    TASK_STACK_SIZE = 2048,
+    MAX_SET_TASKS = 3,
+};
+
+enum Mode
+{
+    FIXED,
+    EDF,
+    NUM_MODES
+};
+
+static const char *const mode_names[NUM_MODES] = {"fixed (RM)", "EDF"};
+
+struct BenchSet
+{
+    const char *name;
+    int count;
+    uint32_t period_us[MAX_SET_TASKS];
+    uint32_t wcet_us[MAX_SET_TASKS];
+};
+
+static const BenchSet bench_sets[] = {
+    {"blink", 2, {500000, 323000}, {240000, 150000}},
+    {"pair", 2, {50000, 70000}, {20000, 40000}},
+    {"three", 3, {40000, 60000, 100000}, {10000, 20000, 40000}},
+};
+static const int num_sets = sizeof(bench_sets) / sizeof(bench_sets[0]);
+
+void benchJob(void *parameters);
+
+// Globals
+static Mode mode;
+static TaskSpec specs[MAX_SET_TASKS];
+static char names[MAX_SET_TASKS][8];
+static volatile int edf_ids[MAX_SET_TASKS];
+static volatile uint32_t jobs[MAX_SET_TASKS];
+static volatile uint32_t misses[MAX_SET_TASKS];
+static uint32_t sched_misses[MAX_SET_TASKS];
+static TickType_t start_tick;
+static int64_t start_us;
+static float loops_per_us;
+
+//*****************************************************************************
+// Functions
+
+// Burn CPU time (not wall time: stops counting while preempted)
+static void work(uint32_t us)
+{
+    uint32_t loops = us * loops_per_us;
+    for (volatile uint32_t i = 0; i < loops; i++)
+        ;
+}
+
+static void calibrate()
+{
+    const uint32_t loops = 100000;
+    int64_t start = esp_timer_get_time();
+    for (volatile uint32_t i = 0; i < loops; i++)
+        ;
+    loops_per_us = (float)loops / (esp_timer_get_time() - start);
+}
+
+//*****************************************************************************
+// Tasks
+
+void benchJob(void *parameters)
+{
+    int n = (int)(uintptr_t)parameters;
+    TaskSpec &task = specs[n];
+    TickType_t period = pdMS_TO_TICKS(task.period_us / 1000);
+    TickType_t wake = start_tick;
+    int id = -1;
+
+    if (mode == EDF)
+    {
+        id = EdfScheduler::join();
+        edf_ids[n] = id;
+    }
+    vTaskDelay(wake - xTaskGetTickCount());
+    while (1)
+    {
+        int64_t release_us = start_us + (int64_t)(wake - start_tick) * portTICK_PERIOD_MS * 1000;
+        if (id >= 0)
+        {
+            EdfScheduler::release(id, wake + period);
+        }
+        work(task.wcet_us);
+        int64_t elapsed = esp_timer_get_time() - release_us;
+        uint32_t response = elapsed > 0 ? (uint32_t)elapsed : 0;
+        task.measured_us = std::max(task.measured_us, response);
+        jobs[n]++;
+        if (id >= 0)
+        {
+            if (!EdfScheduler::complete(id))
+            {
+                misses[n]++;
+            }
+        }
+        else if (response > task.period_us)
+        {
+            misses[n]++;
+        }
+        vTaskDelayUntil(&wake, period);
+    }
+}
+
+//*****************************************************************************
+// Main (runs as its own task with priority 1 on core 1)
+
+static void runSet(const BenchSet &set, Mode m)
+{
+    TaskHandle_t handles[MAX_SET_TASKS];
+    TaskSet task_set(specs, set.count);
+    mode = m;
+    for (int i = 0; i < set.count; i++)
+    {
+        snprintf(names[i], sizeof(names[i]), "T%u", (unsigned)(set.period_us[i] / 1000));
+        specs[i] = {names[i], benchJob, (void *)(uintptr_t)i, TASK_STACK_SIZE, app_cpu,
+                    set.period_us[i], set.wcet_us[i], 0, 0};
+        edf_ids[i] = -1;
+        jobs[i] = 0;
+        misses[i] = 0;
+    }
+    task_set.assignPriorities(TaskSet::RATE_MONOTONIC, band_low);
+    task_set.analyse();
+
+    // Release everything together on a tick edge
+    TickType_t tick = xTaskGetTickCount();
+    while (xTaskGetTickCount() == tick)
+        ;
+    start_tick = xTaskGetTickCount() + pdMS_TO_TICKS(10);
+    start_us = esp_timer_get_time() + 10000;
+    task_set.create(handles);
+    vTaskDelay(pdMS_TO_TICKS(run_ms));
+    for (int i = 0; i < set.count; i++)
+    {
+        vTaskDelete(handles[i]);
+        if (edf_ids[i] >= 0)
+        {
+            sched_misses[i] = EdfScheduler::getMisses(edf_ids[i]);
+            EdfScheduler::leave(edf_ids[i]);
+        }
+    }
+
+    for (int i = 0; i < set.count; i++)
+    {
+        // Predicted worst case for the fixed priorities, the scheduler's miss
+        // count for EDF
+        char predicted[12] = "-";
+        char sched[12] = "-";
+        if (m == EDF)
+        {
+            snprintf(sched, sizeof(sched), "%u", (unsigned)sched_misses[i]);
+        }
+        else if (specs[i].response_us == UINT32_MAX)
+        {
+            strcpy(predicted, "MISS");
+        }
+        else
+        {
+            snprintf(predicted, sizeof(predicted), "%u", (unsigned)specs[i].response_us);
+        }
+        Serial.printf("%-6s %-10s %-5s %6u %7u %6s %10u %10s\r\n",
+                      set.name, mode_names[m], specs[i].name,
+                      (unsigned)jobs[i], (unsigned)misses[i], sched,
+                      (unsigned)specs[i].measured_us, predicted);
+    }
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    delay(1000);
+    Serial.println();
+    Serial.println("---FreeRTOS EDF vs Fixed Priority Benchmark---");
+
+    // Above the bench tasks, so that each run ends on time even when they
+    // fall behind
+    vTaskPrioritySet(NULL, configMAX_PRIORITIES - 1);
+    EdfScheduler::begin(band_low);
+    calibrate();
+
+    Serial.printf("%-6s %-10s %-5s %6s %7s %6s %10s %10s\r\n",
+                  "set", "scheduler", "task", "jobs", "misses", "sched", "max R us", "RTA R us");
+    for (int s = 0; s < num_sets; s++)
+    {
+        for (int m = 0; m < NUM_MODES; m++)
+        {
+            runSet(bench_sets[s], (Mode)m);
+        }
+    }
+}
+
+void loop()
+{
+    delay(10); // Give Wokwi simulator UI time
+}
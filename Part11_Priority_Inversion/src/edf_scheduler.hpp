@@ -0,0 +1,177 @@
+/**
+ * Earliest-deadline-first layer on top of FreeRTOS priorities
+ *
+ * Fixed priorities can only guarantee a mixed-period task set up to about
+ * 70-80% CPU; EDF schedules anything up to 100% (deadlines = periods). The
+ * FreeRTOS scheduler stays in charge: participating tasks live in a band of
+ * priorities [band_low, band_low + MAX_TASKS], and every time a job is
+ * released or completes, the band is re-ranked so that the nearest absolute
+ * deadline gets the highest priority.
+ *
+ *   int id = EdfScheduler::join();
+ *   while (1)
+ *   {
+ *       EdfScheduler::release(id, wake + relative_deadline);
+ *       ... job ...
+ *       EdfScheduler::complete(id);          // false: deadline missed
+ *       vTaskDelayUntil(&wake, period);
+ *   }
+ *
+ * Between jobs a task waits at the top of the band, so when it wakes up it
+ * preempts the running job just long enough to call release() and be
+ * ranked. That costs one extra context switch per release.
+ *
+ * All participants must be pinned to the same core: the re-ranking relies
+ * on vTaskSuspendAll(), which only holds off that core's scheduler.
+ */
+#pragma once
+#include <Arduino.h>
+
+class EdfScheduler
+{
+public:
+    enum
+    {
+        MAX_TASKS = 8,
+    };
+
+    // Participants use priorities band_low to band_low + MAX_TASKS
+    static void begin(UBaseType_t band_low)
+    {
+        get().band_low = band_low;
+    }
+
+    // The calling task takes part. Returns its id, -1 if the table is full.
+    static int join()
+    {
+        State &state = get();
+        int id = -1;
+        vTaskSuspendAll();
+        for (int i = 0; i < MAX_TASKS; i++)
+        {
+            Entry &entry = state.entries[i];
+            if (entry.task == NULL)
+            {
+                entry.task = xTaskGetCurrentTaskHandle();
+                entry.active = false;
+                entry.jobs = 0;
+                entry.misses = 0;
+                id = i;
+                break;
+            }
+        }
+        xTaskResumeAll();
+        if (id >= 0)
+        {
+            vTaskPrioritySet(NULL, top(state));
+        }
+        return id;
+    }
+
+    // Stop taking part (the task may already be deleted)
+    static void leave(int id)
+    {
+        State &state = get();
+        vTaskSuspendAll();
+        state.entries[id].task = NULL;
+        state.entries[id].active = false;
+        xTaskResumeAll();
+    }
+
+    // A new job of task id is ready, due by the absolute tick deadline
+    static void release(int id, TickType_t deadline)
+    {
+        State &state = get();
+        vTaskSuspendAll();
+        state.entries[id].deadline = deadline;
+        state.entries[id].active = true;
+        rank(state);
+        xTaskResumeAll(); // Switches to the nearest deadline
+    }
+
+    // The current job is done. Returns false if it missed its deadline.
+    static bool complete(int id)
+    {
+        State &state = get();
+        bool met = true;
+        vTaskSuspendAll();
+        Entry &entry = state.entries[id];
+        entry.jobs++;
+        if ((int32_t)(xTaskGetTickCount() - entry.deadline) > 0)
+        {
+            entry.misses++;
+            met = false;
+        }
+        entry.active = false;
+        rank(state);
+        vTaskPrioritySet(NULL, top(state)); // Wait for the next release up top
+        xTaskResumeAll();
+        return met;
+    }
+
+    static uint32_t getJobs(int id)
+    {
+        return get().entries[id].jobs;
+    }
+
+    static uint32_t getMisses(int id)
+    {
+        return get().entries[id].misses;
+    }
+
+private:
+    struct Entry
+    {
+        TaskHandle_t task; // NULL = free
+        TickType_t deadline;
+        bool active;       // Job released and not complete
+        uint32_t jobs;
+        uint32_t misses;
+    };
+
+    struct State
+    {
+        Entry entries[MAX_TASKS];
+        UBaseType_t band_low;
+    };
+
+    static State &get()
+    {
+        static State state = {{}, 1};
+        return state;
+    }
+
+    static UBaseType_t top(State &state)
+    {
+        return state.band_low + MAX_TASKS;
+    }
+
+    // Active jobs get band_low + MAX_TASKS - 1 (nearest deadline) downwards
+    // (scheduler suspended)
+    static void rank(State &state)
+    {
+        for (int i = 0; i < MAX_TASKS; i++)
+        {
+            Entry &entry = state.entries[i];
+            if (entry.task == NULL || !entry.active)
+            {
+                continue;
+            }
+            int earlier = 0;
+            for (int j = 0; j < MAX_TASKS; j++)
+            {
+                const Entry &other = state.entries[j];
+                if (j == i || other.task == NULL || !other.active)
+                {
+                    continue;
+                }
+                int32_t diff = (int32_t)(other.deadline - entry.deadline);
+                if (diff < 0 || (diff == 0 && j < i))
+                {
+                    earlier++;
+                }
+            }
+            vTaskPrioritySet(entry.task, top(state) - 1 - earlier);
+        }
+    }
+};
@@ -0,0 +1,300 @@
+/**
+ * Runtime priority inversion detector
+ *
+ * Locks taken through a WatchedLock (mutex or binary semaphore) record their
+ * owner and the tasks blocked on them. A FreeRTOS tick hook on each core
+ * then checks, every tick, whether a blocked task H waits for a lock held by
+ * a lower priority task L while a task M with a priority in between runs
+ * instead of L. That is a priority inversion: when it ends (M stops running,
+ * L gets the CPU back or H gets the lock), a record with the three task
+ * names, the lock and how long it lasted goes into a small ring buffer.
+ *
+ * On two cores, H, L and M must all be able to run on the core whose hook
+ * sees M: pinned to it, or not pinned. A task running on one core doesn't
+ * keep a task pinned to the other core off the CPU.
+ *
+ * The hook only looks at up to MAX_WAITS blocked tasks and the ring
+ * overwrites its oldest record when full, so it can stay on in production.
+ * It runs in the tick interrupt, so it and everything it calls are in IRAM.
+ * Durations have tick resolution; inversions shorter than one tick may be
+ * missed.
+ */
+#pragma once
+#include <Arduino.h>
+#include <esp_freertos_hooks.h>
+
+struct InversionRecord
+{
+    char high[configMAX_TASK_NAME_LEN];   // Blocked task
+    char medium[configMAX_TASK_NAME_LEN]; // Running instead of the owner
+    char low[configMAX_TASK_NAME_LEN];    // Owner of the lock
+    const char *resource;
+    TickType_t start;     // Tick the inversion was first seen
+    uint32_t duration_ms;
+};
+
+class WatchedLock
+{
+public:
+    // Watch an existing mutex or binary semaphore
+    void begin(const char *name, SemaphoreHandle_t handle)
+    {
+        this->name = name;
+        this->handle = handle;
+    }
+
+    bool take(TickType_t timeout);
+    void give();
+
+    const char *getName() const
+    {
+        return name;
+    }
+
+    TaskHandle_t IRAM_ATTR getOwner() const
+    {
+        return owner;
+    }
+
+    SemaphoreHandle_t getHandle() const
+    {
+        return handle;
+    }
+
+private:
+    const char *name = "";
+    SemaphoreHandle_t handle = NULL;
+    volatile TaskHandle_t owner = NULL;
+};
+
+class InversionDetector
+{
+public:
+    enum
+    {
+        MAX_WAITS = 8, // Tasks blocked on watched locks at the same time
+        RING_LEN = 16, // Records kept
+    };
+
+    // Install the tick hooks
+    static bool begin()
+    {
+        for (int cpu = 0; cpu < portNUM_PROCESSORS; cpu++)
+        {
+            if (esp_register_freertos_tick_hook_for_cpu(tickHook, cpu) != ESP_OK)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Oldest record, false if there is none
+    static bool read(InversionRecord &record)
+    {
+        State &state = get();
+        bool found = false;
+        portENTER_CRITICAL(&state.lock);
+        if (state.count > 0)
+        {
+            record = state.ring[(state.head + RING_LEN - state.count) % RING_LEN];
+            state.count--;
+            found = true;
+        }
+        portEXIT_CRITICAL(&state.lock);
+        return found;
+    }
+
+    static void print(const InversionRecord &record)
+    {
+        Serial.printf("Priority inversion on \"%s\": %s waited %u ms while %s ran and %s held it\r\n",
+                      record.resource, record.high, (unsigned)record.duration_ms,
+                      record.medium, record.low);
+    }
+
+    // Records overwritten before they were read
+    static uint32_t getLost()
+    {
+        return get().lost;
+    }
+
+    // Called by WatchedLock around a blocking take. Returns the slot, -1 if
+    // the table is full (the wait isn't watched).
+    static int waitBegin(const WatchedLock *lock)
+    {
+        State &state = get();
+        int slot = -1;
+        portENTER_CRITICAL(&state.lock);
+        for (int i = 0; i < MAX_WAITS; i++)
+        {
+            if (state.waits[i].waiter == NULL)
+            {
+                state.waits[i].waiter = xTaskGetCurrentTaskHandle();
+                state.waits[i].lock = lock;
+                state.waits[i].active = false;
+                slot = i;
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&state.lock);
+        return slot;
+    }
+
+    static void waitEnd(int slot)
+    {
+        if (slot < 0)
+        {
+            return;
+        }
+        State &state = get();
+        portENTER_CRITICAL(&state.lock);
+        Wait &wait = state.waits[slot];
+        if (wait.active)
+        {
+            push(state, wait, xTaskGetTickCount());
+        }
+        wait.waiter = NULL;
+        portEXIT_CRITICAL(&state.lock);
+    }
+
+private:
+    struct Wait
+    {
+        TaskHandle_t waiter; // NULL = free slot
+        const WatchedLock *lock;
+        bool active;         // Inversion in progress
+        BaseType_t core;     // Where the medium task runs
+        TaskHandle_t medium;
+        TaskHandle_t low;
+        TickType_t start;
+    };
+
+    struct State
+    {
+        Wait waits[MAX_WAITS];
+        InversionRecord ring[RING_LEN];
+        int head;  // Next record to write
+        int count; // Unread records
+        volatile uint32_t lost;
+        portMUX_TYPE lock;
+    };
+
+    static State &get()
+    {
+        static State state = {{}, {}, 0, 0, 0, portMUX_INITIALIZER_UNLOCKED};
+        return state;
+    }
+
+    // By hand rather than strncpy(), which may be in flash
+    static void IRAM_ATTR copyName(char *dst, TaskHandle_t task)
+    {
+        const char *src = pcTaskGetName(task);
+        int i = 0;
+        for (; i < configMAX_TASK_NAME_LEN - 1 && src[i] != '\0'; i++)
+        {
+            dst[i] = src[i];
+        }
+        dst[i] = '\0';
+    }
+
+    // End the wait's inversion and record it (lock held)
+    static void IRAM_ATTR push(State &state, Wait &wait, TickType_t now)
+    {
+        InversionRecord &record = state.ring[state.head];
+        copyName(record.high, wait.waiter);
+        copyName(record.medium, wait.medium);
+        copyName(record.low, wait.low);
+        record.resource = wait.lock->getName();
+        record.start = wait.start;
+        record.duration_ms = (now - wait.start) * portTICK_PERIOD_MS;
+        state.head = (state.head + 1) % RING_LEN;
+        if (state.count < RING_LEN)
+        {
+            state.count++;
+        }
+        else
+        {
+            state.lost++;
+        }
+        wait.active = false;
+    }
+
+    static bool IRAM_ATTR runningElsewhere(TaskHandle_t task, BaseType_t core)
+    {
+        for (int cpu = 0; cpu < portNUM_PROCESSORS; cpu++)
+        {
+            if (cpu != core && xTaskGetCurrentTaskHandleForCPU(cpu) == task)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Task pinned to core, or free to run on any core
+    static bool IRAM_ATTR canRunOn(TaskHandle_t task, BaseType_t core)
+    {
+        BaseType_t affinity = xTaskGetAffinity(task);
+        return affinity == core || affinity == tskNO_AFFINITY;
+    }
+
+    static void IRAM_ATTR tickHook()
+    {
+        State &state = get();
+        BaseType_t core = xPortGetCoreID();
+        TaskHandle_t running = xTaskGetCurrentTaskHandleForCPU(core);
+        TickType_t now = xTaskGetTickCountFromISR();
+
+        portENTER_CRITICAL_ISR(&state.lock);
+        for (int i = 0; i < MAX_WAITS; i++)
+        {
+            Wait &wait = state.waits[i];
+            if (wait.waiter == NULL || (wait.active && wait.core != core))
+            {
+                continue; // Free, or another core's inversion
+            }
+            TaskHandle_t owner = wait.lock->getOwner();
+            bool inverted = false;
+            if (owner != NULL && owner != running && running != wait.waiter &&
+                !runningElsewhere(owner, core) &&
+                canRunOn(wait.waiter, core) && canRunOn(owner, core))
+            {
+                UBaseType_t high = uxTaskPriorityGetFromISR(wait.waiter);
+                UBaseType_t medium = uxTaskPriorityGetFromISR(running);
+                UBaseType_t low = uxTaskPriorityGetFromISR(owner);
+                inverted = low < medium && medium < high;
+            }
+            if (inverted && !wait.active)
+            {
+                wait.active = true;
+                wait.core = core;
+                wait.medium = running;
+                wait.low = owner;
+                wait.start = now;
+            }
+            else if (!inverted && wait.active)
+            {
+                push(state, wait, now);
+            }
+        }
+        portEXIT_CRITICAL_ISR(&state.lock);
+    }
+};
+
+inline bool WatchedLock::take(TickType_t timeout)
+{
+    int slot = InversionDetector::waitBegin(this);
+    bool taken = xSemaphoreTake(handle, timeout) == pdTRUE;
+    InversionDetector::waitEnd(slot);
+    if (taken)
+    {
+        owner = xTaskGetCurrentTaskHandle();
+    }
+    return taken;
+}
+
+inline void WatchedLock::give()
+{
+    owner = NULL;
+    xSemaphoreGive(handle);
+}
@@ -0,0 +1,271 @@
+/**
+ * Priority Inversion Benchmark: worst-case blocking of Task H
+ *
+ * Two resources, A and B, and four tasks on one core, released every round:
+ *   Task L1 (prio 2)  t = 0 ms  uses A for 5 ms
+ *   Task L2 (prio 3)  t = 1 ms  uses B for 5 ms
+ *   Task M  (prio 4)  t = 2 ms  works 20 ms, no resources
+ *   Task H  (prio 5)  t = 3 ms  uses A for 1 ms, then B for 1 ms
+ * under each way of protecting A and B:
+ *  - inheritance: FreeRTOS mutexes (priority_inheritance_demo.cpp). L2
+ *    preempts L1 and takes B, so H inherits its way through both critical
+ *    sections (chained blocking).
+ *  - critical section: portENTER_CRITICAL (critical_section_sol.cpp). Nothing
+ *    preempts L1, but interrupts on the core are off for the whole 5 ms.
+ *  - ceiling: CeilingMutex, ceiling 5. L1 runs at H's priority while it
+ *    holds A, so L2 can't take B and H waits for one critical section.
+ * H's blocking is its response time (release to done) minus its own 2 ms of
+ * work. A 10 kHz timer interrupt on the same core measures the longest gap
+ * between interrupts.
+ */
+#include <Arduino.h>
+#include "ceiling_mutex.hpp"
+
+static const BaseType_t app_cpu = 1;
+
+// Settings
+static const int rounds = 50;
+static const TickType_t round_period = pdMS_TO_TICKS(50);
+static const uint32_t l1_cs_us = 5000; // L1 in A
+static const uint32_t l2_cs_us = 5000; // L2 in B
+static const uint32_t m_work_us = 20000;
+static const uint32_t h_cs_us = 1000; // H in A, then in B
+static const uint64_t isr_period_us = 100;
+
+enum
+{
+    TASK_STACK_SIZE = 2048,
+};
+
+enum Approach
+{
+    INHERITANCE,
+    CRITICAL_SECTION,
+    CEILING,
+    NUM_APPROACHES
+};
+
+static const char *const approach_names[NUM_APPROACHES] = {
+    "inheritance", "critical section", "ceiling"};
+
+enum Resource
+{
+    RES_A,
+    RES_B,
+    NUM_RESOURCES
+};
+
+// One task of the round
+struct Job
+{
+    const char *name;
+    UBaseType_t priority;
+    TickType_t offset;  // Release within the round
+    int resource;       // -1: none
+    uint32_t work_us;
+};
+
+static const Job jobs[] = {
+    {"Task L1", 2, pdMS_TO_TICKS(0), RES_A, l1_cs_us},
+    {"Task L2", 3, pdMS_TO_TICKS(1), RES_B, l2_cs_us},
+    {"Task M", 4, pdMS_TO_TICKS(2), -1, m_work_us},
+    {"Task H", 5, pdMS_TO_TICKS(3), RES_A, h_cs_us}, // Then B
+};
+static const int num_jobs = sizeof(jobs) / sizeof(jobs[0]);
+static const int task_h = num_jobs - 1;
+
+// Globals
+static Approach approach;
+static SemaphoreHandle_t mutexes[NUM_RESOURCES];
+static portMUX_TYPE spinlocks[NUM_RESOURCES] = {portMUX_INITIALIZER_UNLOCKED, portMUX_INITIALIZER_UNLOCKED};
+static CeilingMutex ceilings[NUM_RESOURCES];
+static TickType_t base_tick;        // Release of round 0
+static int64_t base_us;             // esp_timer time at base_tick
+static SemaphoreHandle_t done_sem;
+static uint32_t h_max_block_us;
+static uint64_t h_total_block_us;
+static hw_timer_t *timer = NULL;
+static volatile int64_t last_isr_us = 0;
+static volatile uint32_t max_isr_gap_us = 0;
+
+//*****************************************************************************
+// Interrupt Service Routines (ISRs)
+
+void IRAM_ATTR onTimer()
+{
+    int64_t now = esp_timer_get_time();
+    if (last_isr_us != 0 && now - last_isr_us > max_isr_gap_us)
+    {
+        max_isr_gap_us = now - last_isr_us;
+    }
+    last_isr_us = now;
+}
+
+//*****************************************************************************
+// Functions
+
+static void busyWait(uint32_t us)
+{
+    int64_t start = esp_timer_get_time();
+    while (esp_timer_get_time() - start < us)
+        ;
+}
+
+static void lock(int res)
+{
+    switch (approach)
+    {
+    case INHERITANCE:
+        xSemaphoreTake(mutexes[res], portMAX_DELAY);
+        break;
+    case CRITICAL_SECTION:
+        portENTER_CRITICAL(&spinlocks[res]);
+        break;
+    default:
+        ceilings[res].take(portMAX_DELAY);
+        break;
+    }
+}
+
+static void unlock(int res)
+{
+    switch (approach)
+    {
+    case INHERITANCE:
+        xSemaphoreGive(mutexes[res]);
+        break;
+    case CRITICAL_SECTION:
+        portEXIT_CRITICAL(&spinlocks[res]);
+        break;
+    default:
+        ceilings[res].give();
+        break;
+    }
+}
+
+//*****************************************************************************
+// Tasks
+
+void jobTask(void *parameters)
+{
+    int id = (int)(uintptr_t)parameters;
+    const Job &job = jobs[id];
+    TickType_t wake = base_tick + job.offset;
+
+    vTaskDelay(wake - xTaskGetTickCount());
+    for (int r = 0; r < rounds; r++)
+    {
+        if (r > 0)
+        {
+            vTaskDelayUntil(&wake, round_period);
+        }
+        if (id == task_h)
+        {
+            // Response time from the scheduled release, not from when H got
+            // to run
+            int64_t release_us = base_us + (int64_t)(wake - base_tick) * portTICK_PERIOD_MS * 1000;
+            lock(RES_A);
+            busyWait(h_cs_us);
+            unlock(RES_A);
+            lock(RES_B);
+            busyWait(h_cs_us);
+            unlock(RES_B);
+            uint32_t blocked = esp_timer_get_time() - release_us - 2 * h_cs_us;
+            h_total_block_us += blocked;
+            h_max_block_us = std::max(h_max_block_us, blocked);
+        }
+        else if (job.resource >= 0)
+        {
+            lock(job.resource);
+            busyWait(job.work_us);
+            unlock(job.resource);
+        }
+        else
+        {
+            busyWait(job.work_us);
+        }
+    }
+
+    xSemaphoreGive(done_sem);
+    vTaskSuspend(NULL);
+}
+
+//*****************************************************************************
+// Main (runs as its own task with priority 1 on core 1)
+
+static void runApproach(Approach a)
+{
+    TaskHandle_t tasks[num_jobs];
+    approach = a;
+    h_max_block_us = 0;
+    h_total_block_us = 0;
+
+    // Start on a tick edge so that tick and esp_timer times line up
+    TickType_t tick = xTaskGetTickCount();
+    while (xTaskGetTickCount() == tick)
+        ;
+    base_tick = xTaskGetTickCount() + pdMS_TO_TICKS(10);
+    base_us = esp_timer_get_time() + 10000;
+    max_isr_gap_us = 0;
+    last_isr_us = 0;
+
+    for (int i = 0; i < num_jobs; i++)
+    {
+        xTaskCreatePinnedToCore(jobTask,
+                                jobs[i].name,
+                                TASK_STACK_SIZE,
+                                (void *)(uintptr_t)i,
+                                jobs[i].priority,
+                                &tasks[i],
+                                app_cpu);
+    }
+    for (int i = 0; i < num_jobs; i++)
+    {
+        xSemaphoreTake(done_sem, portMAX_DELAY);
+    }
+    for (int i = 0; i < num_jobs; i++)
+    {
+        vTaskDelete(tasks[i]);
+    }
+
+    Serial.printf("%-16s %10u %10u %10u\r\n",
+                  approach_names[a],
+                  (unsigned)(h_total_block_us / rounds),
+                  (unsigned)h_max_block_us,
+                  (unsigned)max_isr_gap_us);
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    delay(1000);
+    Serial.println();
+    Serial.println("---FreeRTOS Priority Inversion Benchmark---");
+    Serial.printf("%d rounds, L1 holds A %u us, L2 holds B %u us, H needs A then B\r\n",
+                  rounds, (unsigned)l1_cs_us, (unsigned)l2_cs_us);
+
+    done_sem = xSemaphoreCreateCounting(num_jobs, 0);
+    for (int r = 0; r < NUM_RESOURCES; r++)
+    {
+        mutexes[r] = xSemaphoreCreateMutex();
+        ceilings[r].begin(jobs[task_h].priority);
+    }
+
+    // Interrupt on this core to see how long interrupts are held off
+    timer = timerBegin(0, 80, true);
+    timerAttachInterrupt(timer, &onTimer, true);
+    timerAlarmWrite(timer, isr_period_us, true);
+    timerAlarmEnable(timer);
+
+    Serial.printf("%-16s %10s %10s %10s\r\n", "approach", "H avg us", "H max us", "ISR gap us");
+    for (int a = 0; a < NUM_APPROACHES; a++)
+    {
+        runApproach((Approach)a);
+    }
+    timerAlarmDisable(timer);
+}
+
+void loop()
+{
+    delay(10); // Give Wokwi simulator UI time
+}
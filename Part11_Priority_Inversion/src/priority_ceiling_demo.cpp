@@ -0,0 +1,139 @@
+/**
+ * ESP32 Priority Ceiling Demo
+ *
+ * Same tasks as the priority inheritance demo, but the lock is a
+ * CeilingMutex: Task L runs at Task H's priority while it holds it, so
+ * Task M can't get in between and Task H never waits more than one
+ * critical section.
+ *
+ * Type "stats" for each task's lock wait and hold times (p50/p99/max in
+ * microseconds), "reset" to start over.
+ */
+
+#include <Arduino.h>
+#include "lock_stats.hpp"
+#include "ceiling_mutex.hpp"
+
+static const BaseType_t app_cpu = 1;
+
+TickType_t cs_wait = 250;   // Time spent in critical section (ms)
+TickType_t med_wait = 5000; // Time medium task spends working (ms)
+
+static ProfiledLock<CeilingMutex> lock; // Ceiling: Task H's priority
+
+static inline TickType_t getTimestamp()
+{
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+// Task L (low priority)
+void doTaskL(void *parameters)
+{
+    TickType_t timestamp;
+    while (1)
+    {
+        // Take lock
+        Serial.println("Task L trying to take lock ...");
+        lock.take(portMAX_DELAY); // Wait time goes to the lock's histogram
+        Serial.println("Task L got lock. Doing some work ...");
+
+        // Hog the processor for a while doing nothing (don't yeild)
+        timestamp = getTimestamp();
+        while (getTimestamp() - timestamp < cs_wait)
+            ;
+
+        // Release lock
+        Serial.println("Task L releasing lock.");
+        lock.give();
+
+        // Go to sleep
+        vTaskDelay(500 / portTICK_PERIOD_MS);
+    }
+}
+
+// Task M (medium priority)
+void doTaskM(void *parameters)
+{
+    TickType_t timestamp;
+    while (1)
+    {
+        // Hog the processor for a while doing nothing
+        Serial.println("Task M doing some work ...");
+        timestamp = getTimestamp();
+        while (getTimestamp() - timestamp < med_wait)
+            ;
+        // Go to sleep
+        Serial.println("Task M done!");
+        delay(500);
+    }
+}
+
+// Task H (high priority)
+void doTaskH(void *parameters)
+{
+    TickType_t timestamp;
+    while (1)
+    {
+        // Take lock
+        Serial.println("Task H trying to take lock ...");
+        lock.take(portMAX_DELAY); // Wait time goes to the lock's histogram
+        Serial.println("Task H got lock. Doing some work ...");
+
+        // Hog the processor for a while
+        timestamp = getTimestamp();
+        while (getTimestamp() - timestamp < cs_wait)
+            ;
+
+        // Release lock
+        Serial.println("Task H releasing lock.");
+        lock.give();
+
+        // Go to sleep
+        delay(500);
+    }
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    delay(1000);
+    Serial.println();
+    Serial.println("---FreeRTOS Priority Ceiling Demo---");
+
+    lock.begin("lock", 3);
+
+    // The order of starting the tasks matters to force priority inversion
+    xTaskCreatePinnedToCore(doTaskL,
+                            "Task L",
+                            1024,
+                            NULL,
+                            1,
+                            NULL,
+                            app_cpu);
+
+    // delay to force the priority inversion
+    delay(1);
+
+    xTaskCreatePinnedToCore(doTaskH,
+                            "Task H",
+                            1024,
+                            nullptr,
+                            3,
+                            nullptr,
+                            app_cpu);
+
+    xTaskCreatePinnedToCore(doTaskM,
+                            "Task M",
+                            1024,
+                            NULL,
+                            2,
+                            NULL,
+                            app_cpu);
+}
+
+void loop()
+{
+    // "stats" prints the lock histograms, "reset" clears them
+    LockStats::pollCommand();
+    delay(10); // Give Wokwi simulator UI time
+}
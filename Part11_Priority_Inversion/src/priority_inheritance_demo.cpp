@@ -1,16 +1,19 @@
 /**
  * ESP32 Priority Inheritance Demo
  *
+ * Type "stats" for each task's lock wait and hold times (p50/p99/max in
+ * microseconds), "reset" to start over.
  */
 
 #include <Arduino.h>
+#include "lock_stats.hpp"
 
 static const BaseType_t app_cpu = 1;
 
 TickType_t cs_wait = 250;   // Time spent in critical section (ms)
 TickType_t med_wait = 5000; // Time medium task spends working (ms)
 
-static SemaphoreHandle_t lock;
+static ProfiledLock<MutexLock> lock; // FreeRTOS mutex, wait/hold times per task
 
 static inline TickType_t getTimestamp()
 {
@@ -25,13 +28,8 @@ void doTaskL(void *parameters)
     {
         // Take lock
         Serial.println("Task L trying to take lock ...");
-        timestamp = getTimestamp();
-        xSemaphoreTake(lock, portMAX_DELAY);
-
-        // Say how long we spend waiting for a lock
-        Serial.print("Task L got lock. Spent ");
-        Serial.print(getTimestamp() - timestamp);
-        Serial.println(" ms waiting for lock. Doing some work ...");
+        lock.take(portMAX_DELAY); // Wait time goes to the lock's histogram
+        Serial.println("Task L got lock. Doing some work ...");
 
         // Hog the processor for a while doing nothing (don't yeild)
         timestamp = getTimestamp();
@@ -40,7 +38,7 @@ void doTaskL(void *parameters)
 
         // Release lock
         Serial.println("Task L releasing lock.");
-        xSemaphoreGive(lock);
+        lock.give();
 
         // Go to sleep
         vTaskDelay(500 / portTICK_PERIOD_MS);
@@ -72,13 +70,8 @@ void doTaskH(void *parameters)
     {
         // Take lock
         Serial.println("Task H trying to take lock ...");
-        timestamp = getTimestamp();
-        xSemaphoreTake(lock, portMAX_DELAY);
-
-        // Say how long we spend waiting for the lock
-        Serial.print("Task H got lock. Spent ");
-        Serial.print(getTimestamp() - timestamp);
-        Serial.println(" ms waiting for lock. Doing some work ...");
+        lock.take(portMAX_DELAY); // Wait time goes to the lock's histogram
+        Serial.println("Task H got lock. Doing some work ...");
 
         // Hog the processor for a while
         timestamp = getTimestamp();
@@ -87,7 +80,7 @@ void doTaskH(void *parameters)
 
         // Release lock
         Serial.println("Task H releasing lock.");
-        xSemaphoreGive(lock);
+        lock.give();
 
         // Go to sleep
         delay(500);
@@ -101,7 +94,7 @@ void setup()
     Serial.println();
     Serial.println("---FreeRTOS Priority Inversion Demo---");
 
-    lock = xSemaphoreCreateMutex();
+    lock.begin("lock");
 
     // The order of starting the tasks matters to force priority inversion
     xTaskCreatePinnedToCore(doTaskL,
@@ -134,5 +127,7 @@ void setup()
 
 void loop()
 {
+    // "stats" prints the lock histograms, "reset" clears them
+    LockStats::pollCommand();
     delay(10); // Give Wokwi simulator UI time
 }
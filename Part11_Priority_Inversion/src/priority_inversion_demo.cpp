@@ -1,16 +1,20 @@
 /**
  * ESP32 Priority Inversion Demo
  *
+ * The lock is watched by the priority inversion detector: each time Task H
+ * waits for Task L while Task M runs, a record is printed with how long it
+ * lasted.
  */
 
 #include <Arduino.h>
+#include "inversion_detector.hpp"
 
 static const BaseType_t app_cpu = 1;
 
 TickType_t cs_wait = 250;   // Time spent in critical section (ms)
 TickType_t med_wait = 5000; // Time medium task spends working (ms)
 
-static SemaphoreHandle_t lock;
+static WatchedLock lock;
 
 static inline TickType_t getTimestamp()
 {
@@ -26,7 +30,7 @@ void doTaskL(void *parameters)
         // Take lock
         Serial.println("Task L trying to take lock ...");
         timestamp = getTimestamp();
-        xSemaphoreTake(lock, portMAX_DELAY);
+        lock.take(portMAX_DELAY);
 
         // Say how long we spend waiting for a lock
         Serial.print("Task L got lock. Spent ");
@@ -40,7 +44,7 @@ void doTaskL(void *parameters)
 
         // Release lock
         Serial.println("Task L releasing lock.");
-        xSemaphoreGive(lock);
+        lock.give();
 
         // Go to sleep
         vTaskDelay(500 / portTICK_PERIOD_MS);
@@ -73,7 +77,7 @@ void doTaskH(void *parameters)
         // Take lock
         Serial.println("Task H trying to take lock ...");
         timestamp = getTimestamp();
-        xSemaphoreTake(lock, portMAX_DELAY);
+        lock.take(portMAX_DELAY);
 
         // Say how long we spend waiting for the lock
         Serial.print("Task H got lock. Spent ");
@@ -87,7 +91,7 @@ void doTaskH(void *parameters)
 
         // Release lock
         Serial.println("Task H releasing lock.");
-        xSemaphoreGive(lock);
+        lock.give();
 
         // Go to sleep
         delay(500);
@@ -101,8 +105,10 @@ void setup()
     Serial.println();
     Serial.println("---FreeRTOS Priority Inversion Demo---");
 
-    lock = xSemaphoreCreateBinary(); // Note: not a mutex!
-    xSemaphoreGive(lock);            // Make sure binary semaphore starts at 1
+    SemaphoreHandle_t sem = xSemaphoreCreateBinary(); // Note: not a mutex!
+    xSemaphoreGive(sem);                              // Make sure binary semaphore starts at 1
+    lock.begin("lock", sem);
+    InversionDetector::begin();
 
     // The order of starting the tasks matters to force priority inversion
     xTaskCreatePinnedToCore(doTaskL,
@@ -135,5 +141,11 @@ void setup()
 
 void loop()
 {
+    // Print inversions as they are detected
+    InversionRecord record;
+    while (InversionDetector::read(record))
+    {
+        InversionDetector::print(record);
+    }
     delay(10); // Give Wokwi simulator UI time
 }
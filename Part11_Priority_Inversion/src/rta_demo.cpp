@@ -0,0 +1,128 @@
+/**
+ * ESP32 Response-Time Analysis Demo
+ *
+ * Four periodic tasks on one core, described once in a TaskSpec table.
+ * "Control" has a deadline shorter than its period:
+ *  - rate monotonic priorities put it below "Sensor" and it misses its
+ *    deadline in the analysis
+ *  - deadline monotonic priorities put it first and the set is schedulable
+ * The tasks are then started with the deadline monotonic priorities, all
+ * released at the same tick (the worst case the analysis assumes), and each
+ * records its longest response time. The table shows predicted (R) and
+ * measured response times side by side.
+ */
+#include <Arduino.h>
+#include "task_set.hpp"
+
+static const BaseType_t app_cpu = 1;
+
+// Settings
+static const uint32_t run_ms = 5000;
+
+enum
+{
+    TASK_STACK_SIZE = 2048,
+    NUM_TASKS = 4,
+};
+
+void periodicJob(void *parameters);
+
+// Globals
+static TaskSpec tasks[NUM_TASKS] = {
+    // name, fn, arg, stack, core, T, C, D, B
+    {"Sensor", periodicJob, &tasks[0], TASK_STACK_SIZE, app_cpu, 20000, 3000, 0, 0},
+    {"Control", periodicJob, &tasks[1], TASK_STACK_SIZE, app_cpu, 50000, 13000, 15000, 0},
+    {"Logger", periodicJob, &tasks[2], TASK_STACK_SIZE, app_cpu, 100000, 15000, 0, 0},
+    {"Display", periodicJob, &tasks[3], TASK_STACK_SIZE, app_cpu, 200000, 30000, 0, 0},
+};
+static TaskSet task_set(tasks, NUM_TASKS);
+static TickType_t start_tick;     // First release of every task
+static int64_t start_us;          // esp_timer time at start_tick
+static float loops_per_us;        // Busy loop calibration
+
+//*****************************************************************************
+// Functions
+
+// Burn CPU time (not wall time: stops counting while preempted)
+static void work(uint32_t us)
+{
+    uint32_t loops = us * loops_per_us;
+    for (volatile uint32_t i = 0; i < loops; i++)
+        ;
+}
+
+static void calibrate()
+{
+    const uint32_t loops = 100000;
+    int64_t start = esp_timer_get_time();
+    for (volatile uint32_t i = 0; i < loops; i++)
+        ;
+    loops_per_us = (float)loops / (esp_timer_get_time() - start);
+}
+
+//*****************************************************************************
+// Tasks
+
+// Release every period, work for the WCET, record the response time
+void periodicJob(void *parameters)
+{
+    TaskSpec *task = (TaskSpec *)parameters;
+    TickType_t wake = start_tick;
+    TickType_t period = pdMS_TO_TICKS(task->period_us / 1000);
+
+    vTaskDelay(wake - xTaskGetTickCount());
+    while (1)
+    {
+        int64_t release_us = start_us + (int64_t)(wake - start_tick) * portTICK_PERIOD_MS * 1000;
+        work(task->wcet_us);
+        int64_t elapsed = esp_timer_get_time() - release_us;
+        uint32_t response = elapsed > 0 ? (uint32_t)elapsed : 0;
+        task->measured_us = std::max(task->measured_us, response);
+        vTaskDelayUntil(&wake, period);
+    }
+}
+
+//*****************************************************************************
+// Main (runs as its own task with priority 1 on core 1)
+
+void setup()
+{
+    TaskHandle_t handles[NUM_TASKS];
+
+    Serial.begin(115200);
+    delay(1000);
+    Serial.println();
+    Serial.println("---FreeRTOS Response-Time Analysis Demo---");
+
+    Serial.println("Rate monotonic:");
+    task_set.assignPriorities(TaskSet::RATE_MONOTONIC, 2);
+    Serial.println(task_set.analyse() ? "schedulable" : "NOT schedulable");
+    task_set.print();
+
+    Serial.println("Deadline monotonic:");
+    task_set.assignPriorities(TaskSet::DEADLINE_MONOTONIC, 2);
+    Serial.println(task_set.analyse() ? "schedulable" : "NOT schedulable");
+    task_set.print();
+
+    // Run it and measure (all released together on a tick edge)
+    calibrate();
+    TickType_t tick = xTaskGetTickCount();
+    while (xTaskGetTickCount() == tick)
+        ;
+    start_tick = xTaskGetTickCount() + pdMS_TO_TICKS(10);
+    start_us = esp_timer_get_time() + 10000;
+    task_set.create(handles);
+    vTaskDelay(pdMS_TO_TICKS(run_ms));
+    for (int i = 0; i < NUM_TASKS; i++)
+    {
+        vTaskDelete(handles[i]);
+    }
+
+    Serial.printf("Measured over %u ms:\r\n", (unsigned)run_ms);
+    task_set.print();
+}
+
+void loop()
+{
+    delay(10); // Give Wokwi simulator UI time
+}
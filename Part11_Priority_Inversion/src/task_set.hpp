@@ -0,0 +1,197 @@
+/**
+ * Task set description, priority assignment and response-time analysis
+ *
+ * Describe the periodic tasks once (period, worst-case execution time,
+ * deadline, core) and let the tool pick the priorities instead of
+ * hand-picking 1/2/3:
+ *  - RATE_MONOTONIC: shorter period, higher priority
+ *  - DEADLINE_MONOTONIC: shorter deadline, higher priority
+ * analyse() runs the classic response-time analysis on each core:
+ *   R = C + B + sum over higher priority tasks j on the core of ceil(R / Tj) * Cj
+ * iterated to a fixed point, and checks R <= D. B is the longest time the
+ * task can be blocked by lower priority tasks (e.g. one critical section
+ * with a CeilingMutex). create() then starts the tasks with the assigned
+ * priorities, and print() shows the predicted response times next to
+ * measured ones when the tasks record them.
+ *
+ * Kernel overhead (ticks, context switches) isn't modelled: leave some
+ * margin in the WCETs.
+ */
+#pragma once
+#include <Arduino.h>
+
+struct TaskSpec
+{
+    // Description
+    const char *name;
+    TaskFunction_t fn;
+    void *arg;
+    uint32_t stack_size;
+    BaseType_t core;
+    uint32_t period_us;
+    uint32_t wcet_us;
+    uint32_t deadline_us; // 0: same as the period
+    uint32_t blocking_us; // Longest blocking by lower priority tasks
+
+    // Filled in by TaskSet
+    UBaseType_t priority;
+    uint32_t response_us; // Predicted worst case, UINT32_MAX if unbounded
+
+    // Filled in by the task, if it measures itself
+    uint32_t measured_us;
+};
+
+class TaskSet
+{
+public:
+    enum Policy
+    {
+        RATE_MONOTONIC,
+        DEADLINE_MONOTONIC,
+    };
+
+    TaskSet(TaskSpec *tasks, int count) : tasks(tasks), count(count)
+    {
+    }
+
+    // Distinct priorities from lowest up, in policy order (ties keep the
+    // order of the table, earlier is higher)
+    void assignPriorities(Policy policy, UBaseType_t lowest = 1)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            int higher = 0; // Tasks that get a higher priority than task i
+            for (int j = 0; j < count; j++)
+            {
+                uint32_t key_i = key(tasks[i], policy);
+                uint32_t key_j = key(tasks[j], policy);
+                if (key_j < key_i || (key_j == key_i && j < i))
+                {
+                    higher++;
+                }
+            }
+            tasks[i].priority = lowest + (count - 1 - higher);
+        }
+    }
+
+    // Response-time analysis, true if every task meets its deadline
+    bool analyse()
+    {
+        bool ok = true;
+        for (int i = 0; i < count; i++)
+        {
+            TaskSpec &task = tasks[i];
+            uint32_t deadline = deadlineOf(task);
+            uint64_t response = task.wcet_us + task.blocking_us;
+            uint64_t previous = 0;
+            while (response != previous && response <= deadline)
+            {
+                previous = response;
+                response = task.wcet_us + task.blocking_us;
+                for (int j = 0; j < count; j++)
+                {
+                    const TaskSpec &other = tasks[j];
+                    if (j != i && other.core == task.core && other.priority > task.priority)
+                    {
+                        response += (previous + other.period_us - 1) / other.period_us * other.wcet_us;
+                    }
+                }
+            }
+            task.response_us = response <= deadline ? (uint32_t)response : UINT32_MAX;
+            ok = ok && response <= deadline;
+        }
+        return ok;
+    }
+
+    // CPU utilisation of one core (0 to 1)
+    float utilisation(BaseType_t core) const
+    {
+        float u = 0;
+        for (int i = 0; i < count; i++)
+        {
+            if (tasks[i].core == core)
+            {
+                u += (float)tasks[i].wcet_us / tasks[i].period_us;
+            }
+        }
+        return u;
+    }
+
+    // Start every task with its assigned priority
+    bool create(TaskHandle_t *handles = NULL)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            const TaskSpec &task = tasks[i];
+            if (xTaskCreatePinnedToCore(task.fn,
+                                        task.name,
+                                        task.stack_size,
+                                        task.arg,
+                                        task.priority,
+                                        handles != NULL ? &handles[i] : NULL,
+                                        task.core) != pdPASS)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Creation parameters and analysis, one task per line
+    void print() const
+    {
+        Serial.printf("%-12s %4s %4s %8s %8s %8s %8s %8s %8s\r\n",
+                      "task", "core", "prio", "T us", "C us", "D us", "B us", "R us", "meas us");
+        for (int i = 0; i < count; i++)
+        {
+            const TaskSpec &task = tasks[i];
+            char response[12];
+            if (task.response_us == UINT32_MAX)
+            {
+                strcpy(response, "MISS");
+            }
+            else
+            {
+                snprintf(response, sizeof(response), "%u", (unsigned)task.response_us);
+            }
+            char measured[12] = "-";
+            if (task.measured_us > 0)
+            {
+                snprintf(measured, sizeof(measured), "%u", (unsigned)task.measured_us);
+            }
+            Serial.printf("%-12s %4d %4u %8u %8u %8u %8u %8s %8s\r\n",
+                          task.name, (int)task.core, (unsigned)task.priority,
+                          (unsigned)task.period_us, (unsigned)task.wcet_us,
+                          (unsigned)deadlineOf(task), (unsigned)task.blocking_us,
+                          response, measured);
+        }
+        for (int core = 0; core < portNUM_PROCESSORS; core++)
+        {
+            int n = 0;
+            for (int i = 0; i < count; i++)
+            {
+                n += tasks[i].core == core;
+            }
+            if (n > 0)
+            {
+                // Liu & Layland: RM always schedulable below n(2^(1/n) - 1)
+                Serial.printf("core %d: utilisation %.1f%%, RM bound %.1f%%\r\n",
+                              core, 100 * utilisation(core), 100 * n * (powf(2, 1.0f / n) - 1));
+            }
+        }
+    }
+
+private:
+    static uint32_t deadlineOf(const TaskSpec &task)
+    {
+        return task.deadline_us != 0 ? task.deadline_us : task.period_us;
+    }
+
+    static uint32_t key(const TaskSpec &task, Policy policy)
+    {
+        return policy == RATE_MONOTONIC ? task.period_us : deadlineOf(task);
+    }
+
+    TaskSpec *tasks;
+    int count;
+};
@@ -11,6 +11,10 @@
 // You'll likely need this on vanilla FreeRTOS
 // #include semphr.h
 #include <Arduino.h>
+#include "measurement.hpp"
+#include "snapshot.hpp"
+#include "periodic_task.hpp"
+#include "lock_stats.hpp"
 
 // Use only core 1 for demo purposes
 static const BaseType_t app_cpu = 1;
@@ -18,6 +22,7 @@ static const BaseType_t pro_cpu = 0;
 
 // Settings
 static const char command[] = "avg";             // Command
+static const char jitter_command[] = "jitter";   // Print CLI loop jitter
 static const uint16_t timer_divider = 8;         // Divide 80 MHz by this --> 10 MHz
 static const uint64_t timer_max_count = 1000000; // Timer counts to this value: 10 MHz / 1M = 10 Hz
 static const uint32_t cli_delay = 20;            // ms delay
@@ -42,14 +47,15 @@ typedef struct Message
 static hw_timer_t *timer = NULL;
 static TaskHandle_t processing_task = NULL;
 static SemaphoreHandle_t sem_done_reading = NULL;
-static portMUX_TYPE spinlock = portMUX_INITIALIZER_UNLOCKED;
+static ProfiledLock<SpinLock> spinlock;
 static QueueHandle_t err_msg_queue;
 static volatile uint16_t buf_0[BUF_LEN];     // One buffer in the pair
 static volatile uint16_t buf_1[BUF_LEN];     // The other buffer in the pair
 static volatile uint16_t *write_to = buf_0;  // Double buffer write pointer
 static volatile uint16_t *read_from = buf_1; // Double buffer read pointer
 static volatile uint8_t buf_overrun = 0;     // Double buffer overrun flag
-static float adc_avg;
+static Snapshot<Measurement> adc_meas;       // Latest block measurement
+static PeriodicTask cli_period;              // CLI loop, no drift
 
 //*****************************************************************************
 // Functions that can be called from anywhere (in this file)
@@ -117,6 +123,8 @@ void doCLI(void *parameters)
     // Clear whole buffer
     memset(cmd_buf, 0, CMD_BUF_LEN);
 
+    cli_period.begin(cli_delay / portTICK_PERIOD_MS);
+
     // Loop forever
     while (1)
     {
@@ -149,8 +157,19 @@ void doCLI(void *parameters)
                 cmd_buf[idx - 1] = '\0';
                 if (strcmp(cmd_buf, command) == 0)
                 {
-                    Serial.print("Average: ");
-                    Serial.println(adc_avg);
+                    // One consistent copy of all fields, no lock needed
+                    Measurement m = adc_meas.read();
+                    Serial.printf("Block %u: average %.1f, RMS %.1f, min %u, max %u\r\n",
+                                  m.seq, m.mean, m.rms, m.min, m.max);
+                }
+                else if (strcmp(cmd_buf, jitter_command) == 0)
+                {
+                    cli_period.print("CLI loop jitter");
+                }
+                else
+                {
+                    // "stats" prints the lock profile, "reset" clears it
+                    LockStats::command(cmd_buf);
                 }
 
                 // Reset receive buffer and index counter
@@ -166,7 +185,7 @@ void doCLI(void *parameters)
         }
 
         // Don't hog the CPU. Yield to other tasks for a while
-        vTaskDelay(cli_delay / portTICK_PERIOD_MS);
+        cli_period.wait();
     }
 }
 
@@ -180,7 +199,7 @@ void calcAverage(void *parameters)
     timerAlarmEnable(timer);
 
     Message msg;
-    float avg;
+    uint32_t seq = 0;
 
     // Loop forever, wait for semaphore, and print value
     while (1)
@@ -189,21 +208,14 @@ void calcAverage(void *parameters)
         // Wait for notification from ISR (similar to binary semaphore)
         ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-        // Calculate average (as floating point value)
-        avg = 0.0;
-        for (int i = 0; i < BUF_LEN; i++)
-        {
-            avg += (float)read_from[i];
-            // vTaskDelay(105 / portTICK_PERIOD_MS); // Uncomment to test overrun flag
-        }
-        avg /= BUF_LEN;
+        // Calculate average, RMS, min and max of the block
+        Measurement m = measureBlock((uint16_t *)read_from, BUF_LEN, ++seq);
+        // vTaskDelay(105 / portTICK_PERIOD_MS); // Uncomment to test overrun flag
 
-        // Updating the shared float may or may not take multiple isntructions, so
-        // we protect it with a mutex or critical section. The ESP-IDF critical
-        // section is the easiest for this application.
-        portENTER_CRITICAL(&spinlock);
-        adc_avg = avg;
-        portEXIT_CRITICAL(&spinlock);
+        // Publish all fields at once. The CLI runs on the other core and
+        // retries if it races with us, so no spinlock (and no interrupts
+        // disabled) is needed here.
+        adc_meas.publish(m);
 
         // If we took too long to process, buffer writing will have overrun. So,
         // we send a message to be printed out to the serial terminal.
@@ -215,10 +227,10 @@ void calcAverage(void *parameters)
 
         // Clearing the overrun flag and giving the "done reading" semaphore must
         // be done together without being interrupted.
-        portENTER_CRITICAL(&spinlock);
+        spinlock.take(portMAX_DELAY);
         buf_overrun = 0;
         xSemaphoreGive(sem_done_reading);
-        portEXIT_CRITICAL(&spinlock);
+        spinlock.give();
     }
 }
 
@@ -246,6 +258,8 @@ void setup()
         ESP.restart();
     }
 
+    spinlock.begin("done reading");
+
     // We want the done reading semaphore to initialize to 1
     xSemaphoreGive(sem_done_reading);
 
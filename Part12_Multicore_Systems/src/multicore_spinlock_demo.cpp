@@ -1,18 +1,120 @@
 /**
  * ESP32 Multicore Spinlock Demo
- * 
+ *
  * Demonstration of crictical sections and ISRs with multicore processor
+ *
+ * Task 0 (core 0) and Task 1 (core 1) each hog one spinlock for time_hog ms
+ * at a time. While one holds it, the other core spins with its interrupts
+ * going on and off. Type "stats" for the contention profile of the lock
+ * (acquisitions, contended, spins, wait and hold cycles per core and per
+ * task), "reset" to start over. Build with -D LOCK_PROFILING.
  */
 
 #include <Arduino.h>
+#include "lock_stats.hpp"
 
 // Using dual-core of ESP32
-static const BaseType_t pro_cpu = 1;
+static const BaseType_t pro_cpu = 0;
 static const BaseType_t app_cpu = 1;
 
-// Settings 
+// Settings
 static const TickType_t time_hog = 1; // Time (ms) hogging the CPU task 1
 static const TickType_t task_0_delay = 30; // Time (ms) Task 0 blocks itself
 static const TickType_t task_1_delay = 100; // Time (ms) Task 1 blocks itself
 
+// Pins
+static const int led_pin = LED_BUILTIN;
 
+// Globals
+static ProfiledLock<SpinLock> spinlock;
+
+//*****************************************************************************
+// Functions
+
+// Busy wait inside the critical section. The tick doesn't advance on a core
+// with interrupts off, so this counts esp_timer time instead.
+static void hogCPU(TickType_t ms)
+{
+    int64_t start = esp_timer_get_time();
+    while (esp_timer_get_time() - start < (int64_t)ms * 1000)
+        ;
+}
+
+//*****************************************************************************
+// Tasks
+
+// Task in Core 0
+void doTask0(void *parameters)
+{
+    // Do forever
+    while (1)
+    {
+        // Hog the lock (and this core) for a while
+        spinlock.take(portMAX_DELAY);
+        hogCPU(time_hog);
+        spinlock.give();
+
+        // Yield processor for a while
+        vTaskDelay(task_0_delay / portTICK_PERIOD_MS);
+    }
+}
+
+// Task in Core 1
+void doTask1(void *parameters)
+{
+    // Do forever
+    while (1)
+    {
+        // Do some long critical section (this is bad practice)
+        spinlock.take(portMAX_DELAY);
+        digitalWrite(led_pin, HIGH);
+        hogCPU(time_hog);
+        digitalWrite(led_pin, LOW);
+        spinlock.give();
+
+        // Yield processor for a while
+        vTaskDelay(task_1_delay / portTICK_PERIOD_MS);
+    }
+}
+
+//*****************************************************************************
+// Main (runs as its own task with priority 1 on core 1)
+
+void setup()
+{
+    // Configure Serial
+    Serial.begin(115200);
+
+    // Wait a moment to start (so we don't miss Serial output)
+    vTaskDelay(1000 / portTICK_PERIOD_MS);
+    Serial.println();
+    Serial.println("---FreeRTOS Multicore Spinlock Demo---");
+
+    pinMode(led_pin, OUTPUT);
+    spinlock.begin("spinlock");
+
+    // Start Task 0 (in Core 0)
+    xTaskCreatePinnedToCore(doTask0,
+                            "Task 0",
+                            1024,
+                            NULL,
+                            1,
+                            NULL,
+                            pro_cpu);
+
+    // Start Task 1 (in Core 1)
+    xTaskCreatePinnedToCore(doTask1,
+                            "Task 1",
+                            1024,
+                            NULL,
+                            1,
+                            NULL,
+                            app_cpu);
+}
+
+void loop()
+{
+    // "stats" prints the lock profile, "reset" clears it
+    LockStats::pollCommand();
+    delay(10); // Give Wokwi simulator UI time
+}
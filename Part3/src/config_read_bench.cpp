@@ -0,0 +1,116 @@
+/**
+ * Config Read Benchmark
+ *
+ * CPU cycles per read of a small config struct:
+ *  - Snapshot<T>::read() (no lock, no kernel call)
+ *  - copy under a FreeRTOS mutex
+ *
+ * Both are measured with nobody writing, and with a writer task on the other
+ * core publishing a new config every millisecond.
+ */
+#include <Arduino.h>
+#include "snapshot.hpp"
+
+// Settings
+static const BaseType_t app_cpu = 1;
+static const BaseType_t pro_cpu = 0;
+static const uint32_t num_reads = 100000;
+
+// Something bigger than a word, so tearing is possible
+struct Config
+{
+    uint32_t on_ms;
+    uint32_t off_ms;
+    uint32_t brightness;
+    uint32_t mode;
+};
+
+// Globals
+static Snapshot<Config> snapshot;
+static Config locked_config;
+static SemaphoreHandle_t config_mutex;
+static volatile bool writer_running = false;
+static volatile uint32_t sink; // Keeps reads from being optimized out
+
+//*****************************************************************************
+// Tasks
+
+// Publish a new config to both variants every millisecond
+void writer(void *parameters)
+{
+    Config cfg = {0, 0, 0, 0};
+    while (1)
+    {
+        if (writer_running)
+        {
+            cfg.on_ms++;
+            cfg.off_ms++;
+            snapshot.publish(cfg);
+
+            xSemaphoreTake(config_mutex, portMAX_DELAY);
+            locked_config = cfg;
+            xSemaphoreGive(config_mutex);
+        }
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+}
+
+//*****************************************************************************
+// Functions that can be called from anywhere (in this file)
+
+static uint32_t cyclesPerSnapshotRead()
+{
+    uint32_t start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < num_reads; i++)
+    {
+        Config cfg = snapshot.read();
+        sink = cfg.on_ms;
+    }
+    return (ESP.getCycleCount() - start) / num_reads;
+}
+
+static uint32_t cyclesPerMutexRead()
+{
+    uint32_t start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < num_reads; i++)
+    {
+        xSemaphoreTake(config_mutex, portMAX_DELAY);
+        Config cfg = locked_config;
+        xSemaphoreGive(config_mutex);
+        sink = cfg.on_ms;
+    }
+    return (ESP.getCycleCount() - start) / num_reads;
+}
+
+//*****************************************************************************
+// Main
+
+void setup()
+{
+    Serial.begin(115200);
+    vTaskDelay(1000 / portTICK_PERIOD_MS);
+    Serial.println();
+    Serial.println("---Config Read Benchmark---");
+
+    snapshot.begin();
+    config_mutex = xSemaphoreCreateMutex();
+    xTaskCreatePinnedToCore(writer, "Writer", 2048, NULL, 1, NULL, pro_cpu);
+
+    Serial.println("writer | snapshot (cycles/read) | mutex (cycles/read)");
+    for (int busy = 0; busy <= 1; busy++)
+    {
+        writer_running = busy;
+        vTaskDelay(pdMS_TO_TICKS(10));
+        uint32_t snap_cycles = cyclesPerSnapshotRead();
+        uint32_t mutex_cycles = cyclesPerMutexRead();
+        Serial.printf("%6s | %22u | %19u\r\n",
+                      busy ? "1 kHz" : "idle", snap_cycles, mutex_cycles);
+    }
+    writer_running = false;
+    Serial.println("Done!");
+}
+
+void loop()
+{
+    delay(100);
+}
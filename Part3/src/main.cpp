@@ -4,14 +4,19 @@
  * FreeRTOS LED Demo
  *
  * One task flashes an LED at a rate specified by a value set in another task.
+ * The blink task's release jitter and overruns are printed every 10 s.
  *
  * Date: December 4, 2020
  * Author: Shawn Hymel
  * License: 0BSD
  */
 
-// Needed for atoi()
+// Needed for strtol()
 #include <stdlib.h>
+// Needed for isspace()
+#include <ctype.h>
+#include "snapshot.hpp"
+#include "periodic_task.hpp"
 
 // Use only core 1 for demo purposes
 #if CONFIG_FREERTOS_UNICORE
@@ -22,31 +27,88 @@ static const BaseType_t app_cpu = 1;
 
 // Settings
 static const uint8_t buf_len = 20;
+static const uint32_t report_ms = 10000; // Time between jitter reports
 
 // Pins
 static const int led_pin = 23;
 
+// LED timing published by readSerial, read by toggleLED
+struct LedConfig
+{
+    int on_ms;
+    int off_ms;
+};
+
 // Globals
-static int led_delay = 500; // ms
+static Snapshot<LedConfig> led_config({500, 500});
+static PeriodicTask blink; // On/off edges on absolute times
+
+//*****************************************************************************
+// Functions
+
+// Parse "<ms>" or "<on ms> <off ms>" (surrounding whitespace allowed). Returns
+// false, leaving cfg alone, unless every field is a number above 0.
+static bool parseConfig(const char *buf, LedConfig &cfg)
+{
+    char *end;
+    long on_ms = strtol(buf, &end, 10);
+    if (end == buf)
+    {
+        return false;
+    }
+    long off_ms = on_ms;
+    const char *rest = end;
+    while (isspace((unsigned char)*rest))
+    {
+        rest++;
+    }
+    if (*rest != '\0')
+    {
+        off_ms = strtol(rest, &end, 10);
+        if (end == rest)
+        {
+            return false;
+        }
+        while (isspace((unsigned char)*end))
+        {
+            end++;
+        }
+        if (*end != '\0')
+        {
+            return false;
+        }
+    }
+    if (on_ms <= 0 || off_ms <= 0 || on_ms > INT32_MAX || off_ms > INT32_MAX)
+    {
+        return false;
+    }
+    cfg.on_ms = on_ms;
+    cfg.off_ms = off_ms;
+    return true;
+}
 
 //*****************************************************************************
 // Tasks
 
-// Task: Blink LED at rate set by global variable
+// Task: Blink LED at rate set by the published config
 void toggleLED(void *parameter)
 {
+    blink.begin(led_config.read().on_ms / portTICK_PERIOD_MS);
     while (1)
     {
+        // Take one consistent copy per period (no lock, no kernel call)
+        LedConfig cfg = led_config.read();
         digitalWrite(led_pin, HIGH);
-        vTaskDelay(led_delay / portTICK_PERIOD_MS);
+        blink.wait(cfg.on_ms / portTICK_PERIOD_MS);
         digitalWrite(led_pin, LOW);
-        vTaskDelay(led_delay / portTICK_PERIOD_MS);
+        blink.wait(cfg.off_ms / portTICK_PERIOD_MS);
     }
 }
 
 // Task: Read from serial terminal
+// Accepts "<ms>" for both halves of the period or "<on ms> <off ms>".
 // Feel free to use Serial.readString() or Serial.parseInt(). I'm going to show
-// it with atoi() in case you're doing this in a non-Arduino environment. You'd
+// it with strtol() in case you're doing this in a non-Arduino environment. You'd
 // also need to replace Serial with your own UART code for non-Arduino.
 void readSerial(void *parameters)
 {
@@ -63,12 +125,25 @@ void readSerial(void *parameters)
         {
             c = Serial.read();
 
-            // Update delay variable and reset buffer if we get a newline character
-            if (c == '\n')
+            // Update delay variable and reset buffer at the end of a line
+            // ('\n', '\r' or both; the empty line between them is skipped)
+            if ((c == '\n') || (c == '\r'))
             {
-                led_delay = atoi(buf);
-                Serial.print("Updated LED delay to: ");
-                Serial.println(led_delay);
+                LedConfig cfg;
+                if (idx > 0 && parseConfig(buf, cfg))
+                {
+                    // Both fields become visible to toggleLED together
+                    led_config.publish(cfg);
+                    Serial.print("Updated LED delay to: ");
+                    Serial.print(cfg.on_ms);
+                    Serial.print(" / ");
+                    Serial.println(cfg.off_ms);
+                }
+                else if (idx > 0)
+                {
+                    Serial.print("Invalid delay: ");
+                    Serial.println(buf);
+                }
                 memset(buf, 0, buf_len);
                 idx = 0;
             }
@@ -99,6 +174,10 @@ void setup()
     vTaskDelay(1000 / portTICK_PERIOD_MS);
     Serial.println("Multi-task LED Demo (Wokwi)");
     Serial.println("Enter a number in milliseconds to change the LED delay.");
+    Serial.println("(or two numbers for separate on/off times)");
+
+    // Create the config writer lock before any task publishes
+    led_config.begin();
 
     // Start blink task
     xTaskCreatePinnedToCore(      // Use xTaskCreate() in vanilla FreeRTOS
@@ -126,6 +205,7 @@ void setup()
 
 void loop()
 {
-    // Execution should never get here
-    delay(100);
+    // Report how well the blink task keeps its on/off times
+    vTaskDelay(report_ms / portTICK_PERIOD_MS);
+    blink.print("Blink jitter");
 }
\ No newline at end of file
@@ -1,14 +1,10 @@
 #include <Arduino.h>
+#include "task_launch.hpp"
 
 static const BaseType_t app_cpu = 1;
 
-SemaphoreHandle_t bin_sem;
-
-void blinkLED(void *pargs)
+void blinkLED(uint32_t delay_arg)
 {
-    uint32_t delay_arg = *(uint32_t *)pargs;
-    xSemaphoreGive(bin_sem);
-
     Serial.print("Recieved delay: ");
     Serial.println(delay_arg);
     pinMode(22, OUTPUT);
@@ -23,8 +19,6 @@ void blinkLED(void *pargs)
 
 void setup()
 {
-    bin_sem = xSemaphoreCreateBinary();
-
     uint32_t delay_arg;
     Serial.begin(115200);
     delay(10);
@@ -40,15 +34,14 @@ void setup()
     Serial.print("Delay: ");
     Serial.println(delay_arg);
 
-    // Start the LED task
-    xTaskCreatePinnedToCore(blinkLED,
-                            "Blink LED",
-                            2048,
-                            (void *)&delay_arg,
-                            1,
-                            NULL,
-                            app_cpu);
-    xSemaphoreTake(bin_sem, portMAX_DELAY);
+    // Start the LED task (delay_arg is copied, so it may go out of scope)
+    LAUNCH_TASK(blinkLED,
+                delay_arg,
+                "Blink LED",
+                2048,
+                1,
+                NULL,
+                app_cpu);
 
     Serial.println("Done!");
 }
@@ -1,9 +1,15 @@
 #include <Arduino.h>
+#include "task_launch.hpp"
+#include "lock_stats.hpp"
 /**
  * FreeRTOS Counting Semaphore Solution
  * 
  * Use producer tasks (writing to shared memory) and consumer tasks (reading 
  * from shared memory) to demonstrate counting semaphores.
+ *
+ * Type "stats" for the contention profile of the buffer mutex, "reset" to
+ * start over (build with -D LOCK_PROFILING). The report is printed while
+ * holding the mutex, so it doesn't interleave with the consumers' output.
  * 
  * Date: January 24, 2021
  * Author: Shawn Hymel
@@ -30,8 +36,7 @@ static const int num_writes = 3;      // Num times each producer writes to buf
 static int buf[BUF_SIZE];             // Shared buffer
 static int head = 0;                  // Writing index to buffer
 static int tail = 0;                  // Reading index to buffer
-static SemaphoreHandle_t bin_sem;     // Waits for parameter to be read
-static SemaphoreHandle_t mutex;       // Lock access to buffer and Serial
+static ProfiledLock<MutexLock> mutex; // Lock access to buffer and Serial
 static SemaphoreHandle_t sem_empty;   // Counts number of empty slots in buf
 static SemaphoreHandle_t sem_filled;  // Counts number of filled slots in buf
 
@@ -39,13 +44,7 @@ static SemaphoreHandle_t sem_filled;  // Counts number of filled slots in buf
 // Tasks
 
 // Producer: write a given number of times to shared buffer
-void producer(void *parameters) {
-
-  // Copy the parameters into a local variable
-  int num = *(int *)parameters;
-
-  // Release the binary semaphore
-  xSemaphoreGive(bin_sem);
+void producer(int num) {
 
   // Fill shared buffer with task number
   for (int i = 0; i < num_writes; i++) {
@@ -54,17 +53,16 @@ void producer(void *parameters) {
     xSemaphoreTake(sem_empty, portMAX_DELAY);
 
     // Lock critical section with a mutex
-    xSemaphoreTake(mutex, portMAX_DELAY);
+    mutex.take(portMAX_DELAY);
     buf[head] = num;
     head = (head + 1) % BUF_SIZE;
-    xSemaphoreGive(mutex);
+    mutex.give();
 
     // Signal to consumer tasks that a slot in the buffer has been filled
     xSemaphoreGive(sem_filled);
   }
 
-  // Delete self task
-  vTaskDelete(NULL);
+  // Return (instead of vTaskDelete) so the launcher can clean up
 }
 
 // Consumer: continuously read from shared buffer
@@ -79,11 +77,11 @@ void consumer(void *parameters) {
     xSemaphoreTake(sem_filled, portMAX_DELAY);
 
     // Lock critical section with a mutex
-    xSemaphoreTake(mutex, portMAX_DELAY);
+    mutex.take(portMAX_DELAY);
     val = buf[tail];
     tail = (tail + 1) % BUF_SIZE;
     Serial.println(val);
-    xSemaphoreGive(mutex);
+    mutex.give();
 
     // Signal to producer thread that a slot in the buffer is free
     xSemaphoreGive(sem_empty);
@@ -106,22 +104,21 @@ void setup() {
   Serial.println("---FreeRTOS Semaphore Solution---");
 
   // Create mutexes and semaphores before starting tasks
-  bin_sem = xSemaphoreCreateBinary();
-  mutex = xSemaphoreCreateMutex();
+  mutex.begin("buffer");
   sem_empty = xSemaphoreCreateCounting(BUF_SIZE, BUF_SIZE);
   sem_filled = xSemaphoreCreateCounting(BUF_SIZE, 0);
 
-  // Start producer tasks (wait for each to read argument)
+  // Start producer tasks (the argument is copied, so no need to wait for
+  // each task to read it)
   for (int i = 0; i < num_prod_tasks; i++) {
     sprintf(task_name, "Producer %i", i);
-    xTaskCreatePinnedToCore(producer,
-                            task_name,
-                            1024,
-                            (void *)&i,
-                            1,
-                            NULL,
-                            app_cpu);
-    xSemaphoreTake(bin_sem, portMAX_DELAY);
+    LAUNCH_TASK(producer,
+                i,
+                task_name,
+                1024,
+                1,
+                NULL,
+                app_cpu);
   }
 
   // Start consumer tasks
@@ -137,13 +134,17 @@ void setup() {
   }
 
   // Notify that all tasks have been created (lock Serial with mutex)
-  xSemaphoreTake(mutex, portMAX_DELAY);
+  mutex.take(portMAX_DELAY);
   Serial.println("All tasks created");
-  xSemaphoreGive(mutex);
+  mutex.give();
 }
 
 void loop() {
 
-  // Do nothing but allow yielding to lower-priority tasks
-  vTaskDelay(1000 / portTICK_PERIOD_MS);
+  // "stats" prints the lock profile, "reset" clears it. Serial is shared
+  // under the mutex (taken directly, so the report isn't profiled itself).
+  LockStats::pollCommand(mutex.get().getHandle());
+
+  // Allow yielding to lower-priority tasks
+  vTaskDelay(100 / portTICK_PERIOD_MS);
 }
\ No newline at end of file
@@ -0,0 +1,184 @@
+/**
+ * Lock-free bounded multi-producer/multi-consumer ring
+ *
+ * Each slot carries a sequence number (Dmitry Vyukov's bounded MPMC queue):
+ * a producer claims a slot with one compare-and-swap on head, writes the item
+ * and publishes it by bumping the slot sequence. Consumers do the same on
+ * tail. No kernel object is touched while the ring is neither empty nor full.
+ *
+ * push()/pop() block only in the full/empty case. The waiter registers itself
+ * in a counter, retries once, then sleeps on a counting semaphore. The other
+ * side only gives that semaphore when someone is registered, so the fast path
+ * stays lock-free. Extra gives just cause an extra retry.
+ *
+ * LEN must be a power of two. T should be cheap to copy (it's copied in and
+ * out of the slot).
+ */
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+template <typename T, uint32_t LEN>
+class MpmcRing
+{
+    static_assert((LEN >= 2) && ((LEN & (LEN - 1)) == 0), "LEN must be a power of two");
+
+public:
+    MpmcRing()
+    {
+        for (uint32_t i = 0; i < LEN; i++)
+        {
+            slots[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Create the wakeup semaphores (call before any blocking push/pop)
+    bool begin()
+    {
+        not_empty = xSemaphoreCreateCounting(UINT16_MAX, 0);
+        not_full = xSemaphoreCreateCounting(UINT16_MAX, 0);
+        return (not_empty != NULL) && (not_full != NULL);
+    }
+
+    // Non-blocking, returns false if the ring is full
+    bool tryPush(const T &item)
+    {
+        uint32_t pos = head.load(std::memory_order_relaxed);
+        while (1)
+        {
+            Slot &slot = slots[pos & (LEN - 1)];
+            uint32_t seq = slot.seq.load(std::memory_order_acquire);
+            int32_t diff = (int32_t)(seq - pos);
+            if (diff == 0)
+            {
+                // Slot is free for this lap, try to claim it
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    slot.item = item;
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false; // Consumer hasn't freed this slot yet: full
+            }
+            else
+            {
+                pos = head.load(std::memory_order_relaxed); // Lost the race
+            }
+        }
+    }
+
+    // Non-blocking, returns false if the ring is empty
+    bool tryPop(T &item)
+    {
+        uint32_t pos = tail.load(std::memory_order_relaxed);
+        while (1)
+        {
+            Slot &slot = slots[pos & (LEN - 1)];
+            uint32_t seq = slot.seq.load(std::memory_order_acquire);
+            int32_t diff = (int32_t)(seq - (pos + 1));
+            if (diff == 0)
+            {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    item = slot.item;
+                    slot.seq.store(pos + LEN, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false; // Producer hasn't filled this slot yet: empty
+            }
+            else
+            {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Push, sleeping while the ring is full (up to timeout ticks per wait)
+    bool push(const T &item, TickType_t timeout = portMAX_DELAY)
+    {
+        while (!tryPush(item))
+        {
+            // Register as a waiter, then retry once: a consumer may have freed
+            // a slot before it could see the registration
+            full_waiters.fetch_add(1);
+            // Pairs with the fence in wake(): either we see the freed slot
+            // or the consumer sees us registered
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (tryPush(item))
+            {
+                full_waiters.fetch_sub(1);
+                break;
+            }
+            BaseType_t woken = xSemaphoreTake(not_full, timeout);
+            full_waiters.fetch_sub(1);
+            if (woken != pdTRUE)
+            {
+                return false;
+            }
+        }
+        wake(empty_waiters, not_empty);
+        return true;
+    }
+
+    // Pop, sleeping while the ring is empty (up to timeout ticks per wait)
+    bool pop(T &item, TickType_t timeout = portMAX_DELAY)
+    {
+        while (!tryPop(item))
+        {
+            empty_waiters.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst); // As in push()
+            if (tryPop(item))
+            {
+                empty_waiters.fetch_sub(1);
+                break;
+            }
+            BaseType_t woken = xSemaphoreTake(not_empty, timeout);
+            empty_waiters.fetch_sub(1);
+            if (woken != pdTRUE)
+            {
+                return false;
+            }
+        }
+        wake(full_waiters, not_full);
+        return true;
+    }
+
+    // Approximate number of items (exact when nobody is pushing or popping)
+    uint32_t size() const
+    {
+        return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<uint32_t> seq;
+        T item;
+    };
+
+    // Only touch the kernel if someone is (about to be) asleep
+    void wake(std::atomic<int32_t> &waiters, SemaphoreHandle_t sem)
+    {
+        // Order the slot publish before reading the waiter count (pairs with
+        // the waiter's fetch_add before its retry)
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load() > 0)
+        {
+            xSemaphoreGive(sem);
+        }
+    }
+
+    Slot slots[LEN];
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+    std::atomic<int32_t> full_waiters{0};
+    std::atomic<int32_t> empty_waiters{0};
+    SemaphoreHandle_t not_empty = NULL;
+    SemaphoreHandle_t not_full = NULL;
+};
@@ -0,0 +1,210 @@
+/**
+ * Producer/Consumer Throughput Benchmark
+ *
+ * Items per second through a small shared buffer (8 slots for both, so only
+ * the synchronization differs) for:
+ *  - semaphore trio: sem_empty + mutex + sem_filled per item (main.cpp)
+ *  - MpmcRing:       lock-free ring, kernel only touched when empty/full
+ *
+ * with 5x2 up to 32x8 producers x consumers, all tasks pinned to one core or
+ * free to run on both. Nothing is printed per item (printing under the
+ * mutex, as main.cpp does, would only make the trio look worse).
+ */
+#include <Arduino.h>
+#include <atomic>
+#include "mpmc_ring.hpp"
+
+static const BaseType_t app_cpu = 1;
+
+// Settings
+enum
+{
+    BUF_SIZE = 8,         // Slots in each buffer (a power of two for the ring)
+    TOTAL_ITEMS = 100000, // Items per run, split over the producers
+    TASK_STACK_SIZE = 2048,
+    STOP = -1,            // Tells a consumer to exit
+};
+
+struct Config
+{
+    int producers;
+    int consumers;
+};
+static const Config configs[] = {{5, 2}, {8, 2}, {16, 4}, {32, 8}};
+
+// Globals
+static int buf[BUF_SIZE];            // Shared buffer
+static int head = 0;                 // Writing index to buffer
+static int tail = 0;                 // Reading index to buffer
+static SemaphoreHandle_t mutex;      // Lock access to buffer
+static SemaphoreHandle_t sem_empty;  // Counts number of empty slots in buf
+static SemaphoreHandle_t sem_filled; // Counts number of filled slots in buf
+static MpmcRing<int, BUF_SIZE> ring;
+
+static SemaphoreHandle_t done_sem;  // Given when the last item is consumed
+static std::atomic<int> consumed;   // Items consumed in this run
+static int items_per_producer;
+
+//*****************************************************************************
+// Tasks
+
+static void semPush(int val)
+{
+    xSemaphoreTake(sem_empty, portMAX_DELAY);
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    buf[head] = val;
+    head = (head + 1) % BUF_SIZE;
+    xSemaphoreGive(mutex);
+    xSemaphoreGive(sem_filled);
+}
+
+void semProducer(void *parameters)
+{
+    for (int i = 0; i < items_per_producer; i++)
+    {
+        semPush(i);
+    }
+    vTaskDelete(NULL);
+}
+
+// Consumers run until they read a negative value (STOP)
+void semConsumer(void *parameters)
+{
+    int val;
+    while (1)
+    {
+        xSemaphoreTake(sem_filled, portMAX_DELAY);
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        val = buf[tail];
+        tail = (tail + 1) % BUF_SIZE;
+        xSemaphoreGive(mutex);
+        xSemaphoreGive(sem_empty);
+
+        if (val == STOP)
+        {
+            vTaskDelete(NULL);
+        }
+        if (consumed.fetch_add(1) + 1 == TOTAL_ITEMS)
+        {
+            xSemaphoreGive(done_sem);
+        }
+    }
+}
+
+void ringProducer(void *parameters)
+{
+    for (int i = 0; i < items_per_producer; i++)
+    {
+        ring.push(i);
+    }
+    vTaskDelete(NULL);
+}
+
+void ringConsumer(void *parameters)
+{
+    int val;
+    while (1)
+    {
+        ring.pop(val);
+        if (val == STOP)
+        {
+            vTaskDelete(NULL);
+        }
+        if (consumed.fetch_add(1) + 1 == TOTAL_ITEMS)
+        {
+            xSemaphoreGive(done_sem);
+        }
+    }
+}
+
+//*****************************************************************************
+// Functions that can be called from anywhere (in this file)
+
+// Returns items per second for one configuration
+static uint32_t runOnce(const Config &cfg, bool use_ring, BaseType_t core)
+{
+    // Give every producer the same share (drop the remainder)
+    items_per_producer = TOTAL_ITEMS / cfg.producers;
+    int total = items_per_producer * cfg.producers;
+    consumed = TOTAL_ITEMS - total;
+
+    uint32_t start = micros();
+    for (int i = 0; i < cfg.consumers; i++)
+    {
+        xTaskCreatePinnedToCore(use_ring ? ringConsumer : semConsumer,
+                                "Consumer",
+                                TASK_STACK_SIZE,
+                                NULL,
+                                1,
+                                NULL,
+                                core);
+    }
+    for (int i = 0; i < cfg.producers; i++)
+    {
+        xTaskCreatePinnedToCore(use_ring ? ringProducer : semProducer,
+                                "Producer",
+                                TASK_STACK_SIZE,
+                                NULL,
+                                1,
+                                NULL,
+                                core);
+    }
+    xSemaphoreTake(done_sem, portMAX_DELAY);
+    uint32_t elapsed = micros() - start;
+
+    // Stop the consumers (they are waiting on an empty buffer now)
+    for (int i = 0; i < cfg.consumers; i++)
+    {
+        if (use_ring)
+        {
+            ring.push(STOP);
+        }
+        else
+        {
+            semPush(STOP);
+        }
+    }
+    vTaskDelay(pdMS_TO_TICKS(100)); // let the idle task free them
+
+    return (uint32_t)((uint64_t)total * 1000000 / elapsed);
+}
+
+//*****************************************************************************
+// Main (runs as its own task with priority 1 on core 1)
+
+void setup()
+{
+    Serial.begin(115200);
+    vTaskDelay(1000 / portTICK_PERIOD_MS);
+    Serial.println();
+    Serial.println("---FreeRTOS Producer/Consumer Throughput Benchmark---");
+
+    mutex = xSemaphoreCreateMutex();
+    sem_empty = xSemaphoreCreateCounting(BUF_SIZE, BUF_SIZE);
+    sem_filled = xSemaphoreCreateCounting(BUF_SIZE, 0);
+    done_sem = xSemaphoreCreateBinary();
+    ring.begin();
+
+    // Run above the workers: all tasks are created before any of them starts,
+    // and the end time is taken as soon as the last item is consumed
+    vTaskPrioritySet(NULL, 2);
+
+    Serial.println("cores | prod x cons | semaphores (items/s) | ring (items/s)");
+    for (int cores = 1; cores <= 2; cores++)
+    {
+        BaseType_t core = (cores == 1) ? app_cpu : tskNO_AFFINITY;
+        for (const Config &cfg : configs)
+        {
+            uint32_t sem_rate = runOnce(cfg, false, core);
+            uint32_t ring_rate = runOnce(cfg, true, core);
+            Serial.printf("%5i | %4i x %-4i | %20u | %14u\r\n",
+                          cores, cfg.producers, cfg.consumers, sem_rate, ring_rate);
+        }
+    }
+    Serial.println("Done!");
+}
+
+void loop()
+{
+    delay(10); // Give time to the Wokwi simulator UI
+}
@@ -0,0 +1,109 @@
+#include <Arduino.h>
+#include "mpmc_ring.hpp"
+#include "task_launch.hpp"
+/**
+ * FreeRTOS Lock-free Ring Producer/Consumer
+ *
+ * Same producers and consumers as main.cpp, but the shared buffer is an
+ * MpmcRing: no sem_empty/mutex/sem_filled per item, and the consumers print
+ * outside of any lock so producers are never stuck behind the UART.
+ */
+
+// Use only core 1 for demo purposes
+#if CONFIG_FREERTOS_UNICORE
+  static const BaseType_t app_cpu = 0;
+#else
+  static const BaseType_t app_cpu = 1;
+#endif
+
+// Settings
+enum {BUF_SIZE = 8};                  // Size of ring (power of two)
+static const int num_prod_tasks = 5;  // Number of producer tasks
+static const int num_cons_tasks = 2;  // Number of consumer tasks
+static const int num_writes = 3;      // Num times each producer writes to buf
+
+// Globals
+static MpmcRing<int, BUF_SIZE> ring;  // Shared buffer
+static SemaphoreHandle_t serial_mutex; // Lock access to Serial only
+
+//*****************************************************************************
+// Tasks
+
+// Producer: write a given number of times to shared buffer
+void producer(int num) {
+
+  // Fill shared buffer with task number (sleeps only if the ring is full)
+  for (int i = 0; i < num_writes; i++) {
+    ring.push(num);
+  }
+}
+
+// Consumer: continuously read from shared buffer
+void consumer(void *parameters) {
+
+  int val;
+
+  // Read from buffer
+  while (1) {
+
+    // Sleeps only if the ring is empty
+    ring.pop(val);
+
+    // Printing no longer holds up the producers
+    xSemaphoreTake(serial_mutex, portMAX_DELAY);
+    Serial.println(val);
+    xSemaphoreGive(serial_mutex);
+  }
+}
+
+//*****************************************************************************
+// Main (runs as its own task with priority 1 on core 1)
+
+void setup() {
+
+  char task_name[12];
+
+  // Configure Serial
+  Serial.begin(115200);
+
+  // Wait a moment to start (so we don't miss Serial output)
+  vTaskDelay(1000 / portTICK_PERIOD_MS);
+  Serial.println();
+  Serial.println("---FreeRTOS Lock-free Ring Solution---");
+
+  // Create kernel objects before starting tasks
+  serial_mutex = xSemaphoreCreateMutex();
+  if (!ring.begin()) {
+    Serial.println("Could not create ring semaphores");
+    ESP.restart();
+  }
+
+  // Start producer tasks
+  for (int i = 0; i < num_prod_tasks; i++) {
+    sprintf(task_name, "Producer %i", i);
+    LAUNCH_TASK(producer, i, task_name, 1024, 1, NULL, app_cpu);
+  }
+
+  // Start consumer tasks
+  for (int i = 0; i < num_cons_tasks; i++) {
+    sprintf(task_name, "Consumer %i", i);
+    xTaskCreatePinnedToCore(consumer,
+                            task_name,
+                            1024,
+                            NULL,
+                            1,
+                            NULL,
+                            app_cpu);
+  }
+
+  // Notify that all tasks have been created
+  xSemaphoreTake(serial_mutex, portMAX_DELAY);
+  Serial.println("All tasks created");
+  xSemaphoreGive(serial_mutex);
+}
+
+void loop() {
+
+  // Do nothing but allow yielding to lower-priority tasks
+  vTaskDelay(1000 / portTICK_PERIOD_MS);
+}
@@ -0,0 +1,151 @@
+/**
+ * Task Launch Benchmark
+ *
+ * Measure the time from creating the first task until all N tasks are
+ * running, for N = 5, 50 and 500:
+ *  - handshake: pass &i and block on bin_sem until each task has read it
+ *  - launch:    LAUNCH_TASK() copies i at creation, tasks are spawned
+ *               back-to-back
+ *
+ * Each task only reports that it is running and returns, so finished tasks
+ * are cleaned up by the idle task. If the heap runs out while spawning, the
+ * creator sleeps for a tick to let the idle task free finished tasks and
+ * tries again (the time spent waiting is part of the result).
+ */
+#include <Arduino.h>
+#include "task_launch.hpp"
+
+static const BaseType_t app_cpu = 1;
+
+// Settings
+static const int task_counts[] = {5, 50, 500};
+enum
+{
+    TASK_STACK_SIZE = 1024,
+    NUM_RUNS = 5, // Runs per configuration (best and average are reported)
+};
+
+// Globals
+static SemaphoreHandle_t bin_sem;     // Waits for parameter to be read
+static SemaphoreHandle_t running_sem; // Counts tasks that have started
+static volatile int checksum;         // Keeps the argument from being optimized out
+
+//*****************************************************************************
+// Tasks
+
+void handshakeTask(void *parameters)
+{
+    int num = *(int *)parameters;
+    xSemaphoreGive(bin_sem);
+
+    checksum += num;
+    xSemaphoreGive(running_sem);
+    vTaskDelete(NULL);
+}
+
+void launchedTask(int num)
+{
+    checksum += num;
+    xSemaphoreGive(running_sem);
+}
+
+//*****************************************************************************
+// Functions that can be called from anywhere (in this file)
+
+// Retry task creation while the idle task catches up with freeing memory
+static void createOrWait(int i, bool handshake)
+{
+    while (1)
+    {
+        BaseType_t ret;
+        if (handshake)
+        {
+            ret = xTaskCreatePinnedToCore(handshakeTask,
+                                          "Worker",
+                                          TASK_STACK_SIZE,
+                                          (void *)&i,
+                                          1,
+                                          NULL,
+                                          app_cpu);
+        }
+        else
+        {
+            ret = LAUNCH_TASK(launchedTask,
+                              i,
+                              "Worker",
+                              TASK_STACK_SIZE,
+                              1,
+                              NULL,
+                              app_cpu);
+        }
+
+        if (ret == pdPASS)
+        {
+            if (handshake)
+            {
+                xSemaphoreTake(bin_sem, portMAX_DELAY);
+            }
+            return;
+        }
+        vTaskDelay(1);
+    }
+}
+
+// Returns microseconds until all num_tasks tasks have started
+static uint32_t timeToAllRunning(int num_tasks, bool handshake)
+{
+    uint32_t start = micros();
+    for (int i = 0; i < num_tasks; i++)
+    {
+        createOrWait(i, handshake);
+    }
+    for (int i = 0; i < num_tasks; i++)
+    {
+        xSemaphoreTake(running_sem, portMAX_DELAY);
+    }
+    uint32_t elapsed = micros() - start;
+
+    // Let the idle task free the finished tasks before the next run
+    vTaskDelay(pdMS_TO_TICKS(100));
+    return elapsed;
+}
+
+//*****************************************************************************
+// Main (runs as its own task with priority 1 on core 1)
+
+void setup()
+{
+    Serial.begin(115200);
+    vTaskDelay(1000 / portTICK_PERIOD_MS);
+    Serial.println();
+    Serial.println("---FreeRTOS Task Launch Benchmark---");
+
+    bin_sem = xSemaphoreCreateBinary();
+    running_sem = xSemaphoreCreateCounting(1000, 0);
+
+    Serial.println("tasks | handshake best/avg (us) | launch best/avg (us)");
+    for (int n : task_counts)
+    {
+        uint32_t best[2] = {UINT32_MAX, UINT32_MAX};
+        uint32_t total[2] = {0, 0};
+        for (int run = 0; run < NUM_RUNS; run++)
+        {
+            for (int mode = 0; mode < 2; mode++)
+            {
+                uint32_t t = timeToAllRunning(n, mode == 0);
+                best[mode] = std::min(best[mode], t);
+                total[mode] += t;
+            }
+        }
+        Serial.printf("%5i | %10u / %10u | %10u / %10u\r\n",
+                      n,
+                      best[0], total[0] / NUM_RUNS,
+                      best[1], total[1] / NUM_RUNS);
+    }
+    Serial.println("Done!");
+}
+
+void loop()
+{
+    delay(10); // Give time to the Wokwi simulator UI
+}
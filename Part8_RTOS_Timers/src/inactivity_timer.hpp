@@ -0,0 +1,116 @@
+/**
+ * Lazily restarted inactivity timeout
+ *
+ * Restarting a FreeRTOS timer on every bit of activity (xTimerStart per
+ * received character) posts one command per event to the timer daemon, and
+ * the caller blocks when the command queue is full. Instead:
+ *  - touch() only stores the current tick. It talks to the daemon only when
+ *    the timer isn't running (the first event after a timeout).
+ *  - when the timer fires, the callback looks at the last activity and, if
+ *    there was some, re-arms itself for the remaining time. The timeout
+ *    callback runs only after a full quiet period.
+ *
+ * A burst of 10k events costs 10k stores plus at most one daemon message.
+ * Extra daemon work is one re-arm per timeout period while events keep
+ * coming.
+ *
+ * A touch() that races with the expiry itself may see on_timeout run just
+ * after it. The timer is still re-armed, so the next timeout is on time.
+ * If the daemon queue is too full to re-arm from the callback, on_timeout
+ * runs early instead of the timeout being lost.
+ */
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+class InactivityTimer
+{
+public:
+    typedef void (*Callback)(InactivityTimer *timer);
+
+    // Create the underlying one-shot timer. on_timeout runs in the timer
+    // daemon after timeout ticks without a touch().
+    bool begin(const char *name, TickType_t timeout, Callback on_timeout)
+    {
+        this->timeout = timeout;
+        this->on_timeout = on_timeout;
+        timer = xTimerCreate(name, timeout, pdFALSE, this, expired);
+        return timer != NULL;
+    }
+
+    // Record activity. Cheap enough to call for every event.
+    void touch()
+    {
+        last_activity.store(xTaskGetTickCount(), std::memory_order_release);
+        if (!armed.exchange(true))
+        {
+            // Timer is idle: this is the only time touch() needs the daemon
+            if (xTimerChangePeriod(timer, timeout, portMAX_DELAY) == pdPASS)
+            {
+                daemon_commands++;
+            }
+        }
+    }
+
+    bool isArmed() const
+    {
+        return armed.load();
+    }
+
+    // Commands posted to the timer daemon so far (touch() and re-arms)
+    uint32_t getDaemonCommands() const
+    {
+        return daemon_commands.load();
+    }
+
+private:
+    // Timer daemon callback
+    static void expired(TimerHandle_t handle)
+    {
+        InactivityTimer *self = (InactivityTimer *)pvTimerGetTimerID(handle);
+        if (self->rearmIfActive())
+        {
+            return;
+        }
+
+        // Quiet for a whole period. Let the next touch() restart the timer.
+        self->armed.store(false);
+
+        // A touch() between the check above and clearing armed saw the timer
+        // still armed and didn't restart it, so check once more
+        if (self->rearmIfActive())
+        {
+            return;
+        }
+        self->on_timeout(self);
+    }
+
+    // Re-arm for the rest of the period if there was activity in it. Returns
+    // false if there wasn't, or if the timer couldn't be re-armed.
+    bool rearmIfActive()
+    {
+        TickType_t idle = xTaskGetTickCount() - last_activity.load(std::memory_order_acquire);
+        if (idle >= timeout)
+        {
+            return false;
+        }
+        armed.store(true);
+        // Called from the daemon itself, so don't block on its own queue. If
+        // the queue is full, fire the timeout early rather than drop it: a
+        // disarmed timer would stay silent until the next touch().
+        if (xTimerChangePeriod(timer, timeout - idle, 0) != pdPASS)
+        {
+            armed.store(false);
+            return false;
+        }
+        daemon_commands++;
+        return true;
+    }
+
+    TimerHandle_t timer = NULL;
+    TickType_t timeout = 0;
+    Callback on_timeout = NULL;
+    std::atomic<TickType_t> last_activity{0};
+    std::atomic<bool> armed{false};
+    std::atomic<uint32_t> daemon_commands{0}; // touch() and the daemon both count
+};
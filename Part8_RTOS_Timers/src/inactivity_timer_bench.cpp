@@ -0,0 +1,102 @@
+/**
+ * Inactivity Timeout Benchmark
+ *
+ * Feed a burst of 10,000 "keystrokes" to a 5 s backlight timeout, once
+ * back-to-back and once paced like 115200 baud input (one every 87 us):
+ *  - xTimerStart per event (as main.cpp used to do)
+ *  - InactivityTimer::touch() per event
+ * and report commands posted to the timer daemon (including re-arms until
+ * the timeout fires) plus the average and worst time the "CLI" spent per
+ * event.
+ */
+#include <Arduino.h>
+#include <atomic>
+#include "inactivity_timer.hpp"
+
+// Settings
+static const uint32_t num_events = 10000;
+static const uint32_t paced_us = 87;    // One character at 115200 baud
+static const TickType_t timeout = pdMS_TO_TICKS(5000);
+
+// Globals
+static TimerHandle_t plain_timer;
+static InactivityTimer lazy_timer;
+static volatile uint32_t timeouts = 0;
+static std::atomic<uint32_t> plain_commands{0}; // Posted by xTimerStart()
+
+//*****************************************************************************
+// Functions that can be called from anywhere (in this file)
+
+void plainCallback(TimerHandle_t timer)
+{
+    timeouts++;
+}
+
+void lazyCallback(InactivityTimer *timer)
+{
+    timeouts++;
+}
+
+static void runBurst(bool lazy, uint32_t gap_us)
+{
+    uint32_t commands_before = lazy ? lazy_timer.getDaemonCommands() : plain_commands.load();
+    uint32_t worst = 0;
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < num_events; i++)
+    {
+        uint32_t t0 = micros();
+        if (lazy)
+        {
+            lazy_timer.touch();
+        }
+        else if (xTimerStart(plain_timer, portMAX_DELAY) == pdPASS)
+        {
+            plain_commands++;
+        }
+        worst = std::max(worst, micros() - t0);
+        if (gap_us > 0)
+        {
+            delayMicroseconds(gap_us);
+        }
+    }
+    uint32_t total = micros() - start - num_events * gap_us;
+
+    // Let the timeout expire (counting the lazy timer's re-arm) before the
+    // next run
+    vTaskDelay(timeout + pdMS_TO_TICKS(100));
+    uint32_t commands = (lazy ? lazy_timer.getDaemonCommands() : plain_commands.load()) - commands_before;
+
+    Serial.printf("%-13s | %-8s | %15u | %10.2f | %8u\r\n",
+                  lazy ? "touch()" : "xTimerStart()",
+                  gap_us ? "paced" : "burst",
+                  commands,
+                  (float)total / num_events,
+                  worst);
+}
+
+//*****************************************************************************
+// Main
+
+void setup()
+{
+    Serial.begin(115200);
+    delay(1000); // for UART connection
+    Serial.println();
+    Serial.println("---Inactivity Timeout Benchmark---");
+
+    plain_timer = xTimerCreate("Plain", timeout, pdFALSE, NULL, plainCallback);
+    lazy_timer.begin("Lazy", timeout, lazyCallback);
+
+    Serial.println("restart with  | input    | daemon commands | avg us/key | worst us");
+    for (int paced = 0; paced <= 1; paced++)
+    {
+        runBurst(false, paced ? paced_us : 0);
+        runBurst(true, paced ? paced_us : 0);
+    }
+    Serial.printf("Timeouts fired: %u (expected 4)\r\n", timeouts);
+}
+
+void loop()
+{
+    delay(1000); // for the simulator UI
+}
@@ -3,12 +3,13 @@
  */
 
 #include <Arduino.h>
+#include "inactivity_timer.hpp"
 #define LCD_BACKLIGHT_PIN 23
 #define BACKLIGHT_TIMEOUT_MS 5000
 
-TimerHandle_t backlight_timer; // one-short
+InactivityTimer backlight_timer; // one-shot, restarted lazily
 
-void backlight_timer_callback(TimerHandle_t xTimer)
+void backlight_timer_callback(InactivityTimer *timer)
 {
     digitalWrite(LCD_BACKLIGHT_PIN, LOW); // turn off the backlight
 }
@@ -21,7 +22,8 @@ void uartCLI(void * pvParameters)
             char c = Serial.read();
             Serial.print(c); // just echo back
             digitalWrite(LCD_BACKLIGHT_PIN, HIGH); // turn on the backlight
-            xTimerStart(backlight_timer, portMAX_DELAY);
+            // Just a timestamp store: no timer daemon command per character
+            backlight_timer.touch();
         }
     }
 }
@@ -36,14 +38,10 @@ void setup()
     pinMode(LCD_BACKLIGHT_PIN, OUTPUT);
     digitalWrite(LCD_BACKLIGHT_PIN, HIGH); // turn on the backlight
 
-    backlight_timer = xTimerCreate("Backlight timer",
-                                   pdMS_TO_TICKS(BACKLIGHT_TIMEOUT_MS),
-                                   pdFALSE,   // auto-reload = false (one-shot)
-                                   (void *)0, // timer ID
-                                   backlight_timer_callback);
-
-    if (backlight_timer != nullptr)
-        xTimerStart(backlight_timer, portMAX_DELAY);
+    if (backlight_timer.begin("Backlight timer",
+                              pdMS_TO_TICKS(BACKLIGHT_TIMEOUT_MS),
+                              backlight_timer_callback))
+        backlight_timer.touch(); // start the first timeout
     
     xTaskCreate(uartCLI, "uartCLI", 2048, NULL, 1, NULL);
 }
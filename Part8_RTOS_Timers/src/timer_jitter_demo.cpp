@@ -0,0 +1,220 @@
+/**
+ * Software Timer Lateness and Jitter under Load
+ *
+ * Runs the one-shot and periodic timers of timers_demo.cpp through
+ * TimerProbe and reports lateness (and jitter for the periodic timer) as
+ * min/mean/p50/p99/max for a fixed list of load scenarios:
+ *  - CPU load: busy tasks on the timer daemon's core, at the daemon's
+ *    priority or above, with a given duty cycle (per 10 ms window)
+ *  - timer queue load: a task posting xTimerReset commands for dummy timers
+ *    every tick, competing with the demo timers for the daemon
+ *
+ * All randomness comes from a fixed-seed generator, so a run can be repeated
+ * and compared after changing a setting.
+ */
+#include <Arduino.h>
+#include "timer_probe.hpp"
+
+// Settings
+static const uint32_t run_ms = 10000;                   // Per scenario
+static const TickType_t one_shot_period = pdMS_TO_TICKS(7);
+static const TickType_t periodic_period = pdMS_TO_TICKS(10);
+static const uint32_t load_window_us = 10000;           // CPU duty cycle window
+static const uint32_t seed = 12345;
+static const int num_dummy_timers = 16;
+
+struct Scenario
+{
+    const char *name;
+    int hog_tasks;
+    int hog_priority;      // Relative to the timer daemon
+    uint32_t hog_duty;     // % of each window spent busy
+    uint32_t cmds_per_tick;
+};
+
+static const Scenario scenarios[] = {
+    {"idle", 0, 0, 0, 0},
+    {"CPU 50% at daemon priority", 1, 0, 50, 0},
+    {"CPU 90% at daemon priority", 1, 0, 90, 0},
+    {"CPU 50% above daemon", 1, 1, 50, 0},
+    {"Queue 8 commands/tick", 0, 0, 0, 8},
+    {"Queue 8 commands/tick + CPU 50%", 1, 0, 50, 8},
+};
+
+// Globals
+static TimerProbe one_shot;
+static TimerProbe periodic;
+static TimerHandle_t dummy_timers[num_dummy_timers];
+static TaskHandle_t main_task = NULL;
+static SemaphoreHandle_t load_done;
+static volatile bool load_running = false;
+static const Scenario *current = NULL;
+
+//*****************************************************************************
+// Functions that can be called from anywhere (in this file)
+
+// Small LCG so every run sees the same sequence
+static uint32_t nextRandom(uint32_t &state)
+{
+    state = state * 1664525UL + 1013904223UL;
+    return state >> 8;
+}
+
+void oneShotCallback(TimerProbe *probe)
+{
+    xTaskNotifyGive(main_task);
+}
+
+void dummyCallback(TimerHandle_t timer)
+{
+}
+
+//*****************************************************************************
+// Tasks
+
+// Busy for hog_duty % of every window (+-20%), sleeps the rest
+void hogTask(void *parameters)
+{
+    uint32_t state = seed + (uint32_t)(uintptr_t)parameters;
+    uint32_t busy_us = load_window_us * current->hog_duty / 100;
+
+    while (load_running)
+    {
+        int64_t start = esp_timer_get_time();
+        uint32_t busy = busy_us * (80 + nextRandom(state) % 41) / 100;
+        busy = std::min(busy, load_window_us - 1000); // Let the idle task in
+        while (esp_timer_get_time() - start < busy)
+        {
+        }
+        uint32_t rest_us = load_window_us - (uint32_t)(esp_timer_get_time() - start);
+        vTaskDelay(std::max(pdMS_TO_TICKS(rest_us / 1000), (TickType_t)1));
+    }
+
+    xSemaphoreGive(load_done);
+    vTaskDelete(NULL);
+}
+
+// Keeps the timer command queue busy with resets of timers that never fire
+void queueTask(void *parameters)
+{
+    uint32_t state = seed;
+    while (load_running)
+    {
+        for (uint32_t i = 0; i < current->cmds_per_tick; i++)
+        {
+            xTimerReset(dummy_timers[nextRandom(state) % num_dummy_timers], portMAX_DELAY);
+        }
+        vTaskDelay(1);
+    }
+
+    xSemaphoreGive(load_done);
+    vTaskDelete(NULL);
+}
+
+//*****************************************************************************
+// Main
+
+static void runScenario(const Scenario &scenario, uint32_t scenario_seed)
+{
+    // The daemon's core is where load hurts timers
+    BaseType_t daemon_cpu = xTaskGetAffinity(xTimerGetTimerDaemonTaskHandle());
+    if (daemon_cpu == tskNO_AFFINITY)
+    {
+        daemon_cpu = 0;
+    }
+
+    current = &scenario;
+    load_running = true;
+    int load_tasks = 0;
+    for (int i = 0; i < scenario.hog_tasks; i++, load_tasks++)
+    {
+        xTaskCreatePinnedToCore(hogTask,
+                                "Hog",
+                                2048,
+                                (void *)(uintptr_t)(scenario_seed + i),
+                                configTIMER_TASK_PRIORITY + scenario.hog_priority,
+                                NULL,
+                                daemon_cpu);
+    }
+    if (scenario.cmds_per_tick > 0)
+    {
+        xTaskCreatePinnedToCore(queueTask,
+                                "Queue load",
+                                2048,
+                                NULL,
+                                configTIMER_TASK_PRIORITY,
+                                NULL,
+                                daemon_cpu);
+        load_tasks++;
+    }
+
+    one_shot.reset();
+    periodic.reset();
+    periodic.start(portMAX_DELAY);
+
+    // Restart the one-shot timer after it fires, after a random pause
+    uint32_t state = scenario_seed;
+    uint32_t missed = 0;
+    uint32_t start = millis();
+    while (millis() - start < run_ms)
+    {
+        one_shot.start(portMAX_DELAY);
+        if (ulTaskNotifyTake(pdTRUE, one_shot_period + pdMS_TO_TICKS(1000)) == 0)
+        {
+            missed++;
+        }
+        vTaskDelay(1 + nextRandom(state) % 20);
+    }
+
+    periodic.stop(portMAX_DELAY);
+    load_running = false;
+    for (int i = 0; i < load_tasks; i++)
+    {
+        xSemaphoreTake(load_done, portMAX_DELAY);
+    }
+
+    Serial.printf("--- %s ---\r\n", scenario.name);
+    one_shot.getLateness().print("one-shot late");
+    periodic.getLateness().print("periodic late");
+    periodic.getJitter().print("periodic jitter");
+    Serial.printf("early callbacks: %u, one-shots never fired: %u\r\n",
+                  one_shot.getEarlyCount() + periodic.getEarlyCount(), missed);
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    delay(1000); // for UART connection
+    Serial.println();
+    Serial.println("---FreeRTOS Software Timer Lateness under Load---");
+
+    main_task = xTaskGetCurrentTaskHandle();
+    load_done = xSemaphoreCreateCounting(8, 0);
+
+    one_shot.begin("One-shot timer", one_shot_period, false, oneShotCallback);
+    periodic.begin("Periodic timer", periodic_period, true);
+    for (int i = 0; i < num_dummy_timers; i++)
+    {
+        dummy_timers[i] = xTimerCreate("Dummy", pdMS_TO_TICKS(60000), pdFALSE, NULL, dummyCallback);
+    }
+
+    Serial.printf("one-shot %u ms, periodic %u ms, %u ms per scenario, seed %u\r\n",
+                  one_shot_period * portTICK_PERIOD_MS,
+                  periodic_period * portTICK_PERIOD_MS,
+                  run_ms, seed);
+    for (uint32_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+    {
+        runScenario(scenarios[i], seed + i * 1000);
+    }
+
+    for (int i = 0; i < num_dummy_timers; i++)
+    {
+        xTimerDelete(dummy_timers[i], portMAX_DELAY);
+    }
+    Serial.println("Done!");
+}
+
+void loop()
+{
+    delay(1000); // for the simulator UI
+}
@@ -0,0 +1,131 @@
+/**
+ * Lateness and jitter probe for a FreeRTOS software timer
+ *
+ * Wraps xTimerCreate/xTimerStart and compares when each callback should run
+ * with when it actually runs (esp_timer_get_time(), microseconds):
+ *  - lateness: actual - scheduled. The daemon computes expiry from the tick
+ *    xTimerStart was called in, so start() first waits for a tick edge to
+ *    know where that tick begins in microseconds.
+ *  - jitter (auto-reload only): how far the interval between two callbacks
+ *    is from the period. FreeRTOS reloads from the expected time, so the
+ *    scheduled times themselves don't drift.
+ *
+ * Callbacks that run up to one tick early (rounding) are counted, not
+ * recorded. The probe sits in the timer ID; the user callback gets its own
+ * value through getArg().
+ */
+#pragma once
+#include <Arduino.h>
+#include "latency_histogram.hpp"
+
+class TimerProbe
+{
+public:
+    typedef void (*Callback)(TimerProbe *probe);
+
+    bool begin(const char *name, TickType_t period, bool auto_reload,
+               Callback callback = NULL, void *arg = NULL)
+    {
+        this->period_us = (int64_t)period * 1000000 / configTICK_RATE_HZ;
+        this->auto_reload = auto_reload;
+        this->callback = callback;
+        this->arg = arg;
+        timer = xTimerCreate(name, period, auto_reload ? pdTRUE : pdFALSE, this, expired);
+        return timer != NULL;
+    }
+
+    // Start (or restart) the timer. Spins for up to one tick to align with
+    // the tick edge, so don't call it from the timer daemon.
+    bool start(TickType_t wait)
+    {
+        TickType_t tick = xTaskGetTickCount();
+        while (xTaskGetTickCount() == tick)
+        {
+        }
+        scheduled_us = esp_timer_get_time() + period_us;
+        last_us = 0;
+        return xTimerStart(timer, wait) == pdPASS;
+    }
+
+    bool stop(TickType_t wait)
+    {
+        return xTimerStop(timer, wait) == pdPASS;
+    }
+
+    void reset()
+    {
+        lateness.reset();
+        jitter.reset();
+        early = 0;
+    }
+
+    const LatencyHistogram &getLateness() const
+    {
+        return lateness;
+    }
+
+    const LatencyHistogram &getJitter() const
+    {
+        return jitter;
+    }
+
+    uint32_t getEarlyCount() const
+    {
+        return early;
+    }
+
+    void *getArg() const
+    {
+        return arg;
+    }
+
+    TimerHandle_t getHandle() const
+    {
+        return timer;
+    }
+
+private:
+    // Timer daemon callback
+    static void expired(TimerHandle_t handle)
+    {
+        int64_t now = esp_timer_get_time();
+        TimerProbe *self = (TimerProbe *)pvTimerGetTimerID(handle);
+
+        int64_t late = now - self->scheduled_us;
+        if (late >= 0)
+        {
+            self->lateness.record((uint32_t)late);
+        }
+        else
+        {
+            self->early++;
+        }
+
+        if (self->auto_reload)
+        {
+            if (self->last_us != 0)
+            {
+                int64_t deviation = now - self->last_us - self->period_us;
+                self->jitter.record((uint32_t)(deviation < 0 ? -deviation : deviation));
+            }
+            self->last_us = now;
+            self->scheduled_us += self->period_us;
+        }
+
+        if (self->callback != NULL)
+        {
+            self->callback(self);
+        }
+    }
+
+    TimerHandle_t timer = NULL;
+    int64_t period_us = 0;
+    bool auto_reload = false;
+    Callback callback = NULL;
+    void *arg = NULL;
+    volatile int64_t scheduled_us = 0; // When the next callback is due
+    int64_t last_us = 0;               // Previous callback (auto-reload)
+    LatencyHistogram lateness;
+    LatencyHistogram jitter;
+    volatile uint32_t early = 0;
+};
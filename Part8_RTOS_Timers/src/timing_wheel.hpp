@@ -0,0 +1,236 @@
+/**
+ * Hierarchical timing wheel
+ *
+ * A timer service for lots of software timers (backlights, debouncers,
+ * retries, ...). The FreeRTOS timer daemon keeps its timers in a sorted list
+ * and every start/reset is a message to the daemon. Here:
+ *  - start/stop/reset are O(1): unlink/link in a slot list under a spinlock
+ *  - 4 levels of 64 slots cover 2^24 ticks (about 4.6 hours at 1 kHz).
+ *    Longer delays or periods are refused by start(), not shortened.
+ *    Level 0 holds the timers due within 64 ticks. Higher levels are
+ *    cascaded down when level 0 wraps.
+ *  - one service task advances the wheel once per tick and runs everything
+ *    that falls due in that tick as a batch. If it runs late, it catches up.
+ *
+ * Timers are caller-owned (static or inside another struct), nothing is
+ * allocated. Callbacks run in the service task, outside the lock, so they may
+ * start/stop timers (including their own).
+ */
+#pragma once
+#include <Arduino.h>
+
+struct WheelTimer;
+typedef void (*WheelCallback)(WheelTimer *timer);
+
+struct WheelTimer
+{
+    WheelTimer *next = NULL; // Slot list links (NULL when not running)
+    WheelTimer *prev = NULL;
+    uint32_t expires = 0;    // Absolute tick
+    uint32_t period = 0;     // 0 = one-shot
+    WheelCallback callback = NULL;
+    void *arg = NULL;        // For the callback's use
+};
+
+class TimingWheel
+{
+public:
+    enum
+    {
+        SLOT_BITS = 6,
+        SLOTS = 1 << SLOT_BITS,
+        LEVELS = 4,
+        MAX_DELAY = (1UL << (SLOT_BITS * LEVELS)) - 1,
+        SERVICE_STACK_SIZE = 3072,
+    };
+
+    TimingWheel()
+    {
+        for (int level = 0; level < LEVELS; level++)
+        {
+            for (int slot = 0; slot < SLOTS; slot++)
+            {
+                // Each slot is a circular list with a dummy head
+                WheelTimer &head = slots[level][slot];
+                head.next = &head;
+                head.prev = &head;
+            }
+        }
+    }
+
+    // Start the service task that advances the wheel every tick
+    bool begin(const char *name, UBaseType_t priority, BaseType_t core)
+    {
+        now = xTaskGetTickCount();
+        return xTaskCreatePinnedToCore(serviceTask,
+                                       name,
+                                       SERVICE_STACK_SIZE,
+                                       this,
+                                       priority,
+                                       NULL,
+                                       core) == pdPASS;
+    }
+
+    // (Re)start timer to fire in delay ticks, then every period ticks
+    // (period 0 = one-shot). Returns false, leaving the timer as it was, if
+    // delay or period is over MAX_DELAY.
+    bool start(WheelTimer &timer, uint32_t delay, uint32_t period = 0)
+    {
+        if (delay > MAX_DELAY || period > MAX_DELAY)
+        {
+            return false;
+        }
+        portENTER_CRITICAL(&lock);
+        unlink(timer);
+        timer.period = period;
+        timer.expires = now + std::max(delay, (uint32_t)1);
+        link(timer);
+        portEXIT_CRITICAL(&lock);
+        return true;
+    }
+
+    // Restart the countdown from now, keeping the timer's period
+    bool reset(WheelTimer &timer, uint32_t delay)
+    {
+        return start(timer, delay, timer.period);
+    }
+
+    void stop(WheelTimer &timer)
+    {
+        portENTER_CRITICAL(&lock);
+        unlink(timer);
+        portEXIT_CRITICAL(&lock);
+    }
+
+    bool isRunning(const WheelTimer &timer) const
+    {
+        return timer.next != NULL;
+    }
+
+    // Move the wheel forward to tick target, firing everything due on the way.
+    // Normally called by the service task, public so another tick source can
+    // drive the wheel instead.
+    void advanceTo(uint32_t target)
+    {
+        while ((int32_t)(target - now) > 0)
+        {
+            portENTER_CRITICAL(&lock);
+            now++;
+            cascade();
+            WheelTimer &head = slots[0][now & (SLOTS - 1)];
+            portEXIT_CRITICAL(&lock);
+
+            // Fire the slot one timer at a time, so callbacks run unlocked and
+            // may stop any timer (even one due in this same tick)
+            while (1)
+            {
+                portENTER_CRITICAL(&lock);
+                WheelTimer *timer = head.next;
+                if (timer == &head)
+                {
+                    portEXIT_CRITICAL(&lock);
+                    break;
+                }
+                unlink(*timer);
+                if (timer->period != 0)
+                {
+                    // Re-arm from the due time, not from now: no drift
+                    timer->expires += timer->period;
+                    link(*timer);
+                }
+                WheelCallback callback = timer->callback;
+                portEXIT_CRITICAL(&lock);
+
+                fired++;
+                if (callback != NULL)
+                {
+                    callback(timer);
+                }
+            }
+        }
+    }
+
+    uint32_t getTick() const
+    {
+        return now;
+    }
+
+    uint32_t getFiredCount() const
+    {
+        return fired;
+    }
+
+private:
+    static void serviceTask(void *parameters)
+    {
+        TimingWheel *wheel = (TimingWheel *)parameters;
+        TickType_t last_wake = xTaskGetTickCount();
+        while (1)
+        {
+            vTaskDelayUntil(&last_wake, 1);
+            wheel->advanceTo(xTaskGetTickCount());
+        }
+    }
+
+    // Put the timer in the slot matching how far away it is (lock held).
+    // start() keeps delays and periods within MAX_DELAY, so it always fits.
+    void link(WheelTimer &timer)
+    {
+        uint32_t delta = timer.expires - now;
+        if ((int32_t)delta <= 0)
+        {
+            // Cascaded on its due tick: goes in the level 0 slot that is
+            // about to be fired
+            delta = 0;
+        }
+
+        int level = 0;
+        while (delta >= (1UL << (SLOT_BITS * (level + 1))))
+        {
+            level++;
+        }
+        int slot = (timer.expires >> (SLOT_BITS * level)) & (SLOTS - 1);
+
+        WheelTimer &head = slots[level][slot];
+        timer.next = &head;
+        timer.prev = head.prev;
+        head.prev->next = &timer;
+        head.prev = &timer;
+    }
+
+    void unlink(WheelTimer &timer)
+    {
+        if (timer.next != NULL)
+        {
+            timer.prev->next = timer.next;
+            timer.next->prev = timer.prev;
+            timer.next = NULL;
+            timer.prev = NULL;
+        }
+    }
+
+    // When a level wraps, spread the next slot of the level above over the
+    // levels below (lock held)
+    void cascade()
+    {
+        for (int level = 1; level < LEVELS; level++)
+        {
+            if ((now & ((1UL << (SLOT_BITS * level)) - 1)) != 0)
+            {
+                break;
+            }
+            WheelTimer &head = slots[level][(now >> (SLOT_BITS * level)) & (SLOTS - 1)];
+            while (head.next != &head)
+            {
+                WheelTimer *timer = head.next;
+                unlink(*timer);
+                link(*timer);
+            }
+        }
+    }
+
+    WheelTimer slots[LEVELS][SLOTS];
+    uint32_t now = 0;                   // Last processed tick
+    volatile uint32_t fired = 0;        // Callbacks run so far
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+};
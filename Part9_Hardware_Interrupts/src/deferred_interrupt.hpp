@@ -0,0 +1,150 @@
+/**
+ * Deferred interrupt processing through task notifications
+ *
+ * Binds a periodic hardware timer ISR (periodicHWTimer) to a handler task:
+ *  - isr_work runs in the ISR and returns the event bits to post (0 = none)
+ *  - the bits are OR'ed into the handler task's notification value
+ *    (eSetBits), so events of different kinds posted before the task runs
+ *    are all delivered in one wake-up
+ *  - posting a bit that is still pending means the handler missed an
+ *    occurrence. It is coalesced into the pending one and counted.
+ *  - the task_woken / portYIELD_FROM_ISR boilerplate lives here
+ *
+ * The handler gets the bits and the number of occurrences coalesced since it
+ * last ran. A notification is lighter than a binary semaphore (no queue
+ * object, no extra lock), see deferred_interrupt_bench.cpp.
+ *
+ * Other ISRs can post through postFromISR().
+ */
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "utilities.hpp"
+
+class DeferredInterrupt
+{
+public:
+    typedef uint32_t (*IsrWork)();
+    typedef void (*Handler)(uint32_t bits, uint32_t missed);
+
+    enum
+    {
+        NUM_TIMERS = 4, // ESP32 hardware timers
+    };
+
+    // Create the handler task, then start hardware timer number with an ISR
+    // every ms milliseconds. Returns false if the task can't be created or
+    // the timer is already bound.
+    bool begin(uint8_t number, uint64_t ms, IsrWork isr_work, Handler handler,
+               const char *name, uint32_t stack_size, UBaseType_t priority, BaseType_t core)
+    {
+        // timerAttachInterrupt takes a plain function, so one entry per timer
+        static void (*const isr_entries[NUM_TIMERS])() = {
+            isrEntry<0>, isrEntry<1>, isrEntry<2>, isrEntry<3>};
+
+        if (number >= NUM_TIMERS || instances()[number] != NULL)
+        {
+            return false;
+        }
+        this->isr_work = isr_work;
+        if (!begin(handler, name, stack_size, priority, core))
+        {
+            return false;
+        }
+        instances()[number] = this;
+        timer = periodicHWTimer(number, ms, isr_entries[number]);
+        return true;
+    }
+
+    // Only create the handler task, for ISRs that call postFromISR()
+    // themselves
+    bool begin(Handler handler, const char *name, uint32_t stack_size,
+               UBaseType_t priority, BaseType_t core)
+    {
+        this->handler = handler;
+        return xTaskCreatePinnedToCore(handlerTask,
+                                       name,
+                                       stack_size,
+                                       this,
+                                       priority,
+                                       &task,
+                                       core) == pdPASS;
+    }
+
+    // Post event bits to the handler task (ISR context only)
+    inline void IRAM_ATTR postFromISR(uint32_t bits)
+    {
+        uint32_t pending = 0;
+        BaseType_t task_woken = pdFALSE;
+        xTaskNotifyAndQueryFromISR(task, bits, eSetBits, &pending, &task_woken);
+        if (pending & bits)
+        {
+            missed.fetch_add(1, std::memory_order_relaxed);
+            missed_total++;
+        }
+
+        // Exit from ISR (ESP-IDF)
+        if (task_woken)
+        {
+            portYIELD_FROM_ISR();
+        }
+    }
+
+    // Occurrences coalesced into a pending one since begin()
+    uint32_t getMissedTotal() const
+    {
+        return missed_total;
+    }
+
+    hw_timer_t *getTimer() const
+    {
+        return timer;
+    }
+
+    TaskHandle_t getTask() const
+    {
+        return task;
+    }
+
+private:
+    inline void IRAM_ATTR fire()
+    {
+        uint32_t bits = isr_work();
+        if (bits != 0)
+        {
+            postFromISR(bits);
+        }
+    }
+
+    static void handlerTask(void *parameters)
+    {
+        DeferredInterrupt *self = (DeferredInterrupt *)parameters;
+        while (1)
+        {
+            uint32_t bits = 0;
+            xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+            self->handler(bits, self->missed.exchange(0, std::memory_order_relaxed));
+        }
+    }
+
+    template <uint8_t N>
+    static void IRAM_ATTR isrEntry()
+    {
+        instances()[N]->fire();
+    }
+
+    // Which object each hardware timer's ISR is bound to
+    static inline DeferredInterrupt **IRAM_ATTR instances()
+    {
+        static DeferredInterrupt *bound[NUM_TIMERS] = {};
+        return bound;
+    }
+
+    IsrWork isr_work = NULL;
+    Handler handler = NULL;
+    TaskHandle_t task = NULL;
+    hw_timer_t *timer = NULL;
+    std::atomic<uint32_t> missed{0};      // Since the handler last ran
+    volatile uint32_t missed_total = 0;
+};
+
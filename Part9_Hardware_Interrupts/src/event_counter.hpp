@@ -0,0 +1,55 @@
+/**
+ * Lock-free event counter with one slot per core
+ *
+ * ISRs and tasks count events without a spinlock: each core adds to its own
+ * slot with an atomic add, so interrupts stay enabled and the two cores
+ * never fight over one word. Readers sum the slots, or drain them (take and
+ * zero every slot with an atomic exchange) to consume everything counted so
+ * far in one pass.
+ *
+ * Counts are 32 bit per slot and wrap.
+ */
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+class EventCounter
+{
+public:
+    enum
+    {
+        NUM_CORES = portNUM_PROCESSORS,
+    };
+
+    // Safe from ISRs and tasks on either core
+    inline void IRAM_ATTR add(uint32_t n = 1)
+    {
+        slots[xPortGetCoreID()].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    // Total counted and not drained yet
+    uint32_t sum() const
+    {
+        uint32_t total = 0;
+        for (int core = 0; core < NUM_CORES; core++)
+        {
+            total += slots[core].load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    // Take everything counted so far and reset to 0. No event is lost or
+    // counted twice: one that lands during the drain is left for next time.
+    uint32_t drain()
+    {
+        uint32_t total = 0;
+        for (int core = 0; core < NUM_CORES; core++)
+        {
+            total += slots[core].exchange(0, std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    std::atomic<uint32_t> slots[NUM_CORES] = {};
+};
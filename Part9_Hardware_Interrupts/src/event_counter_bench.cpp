@@ -0,0 +1,169 @@
+/**
+ * Event Counter Benchmark
+ *
+ * Compares the spinlock-guarded counter of the original
+ * isr_critical_section_demo.cpp with EventCounter, in CPU cycles:
+ *  - cost per increment, from one core and from both cores at once
+ *  - how long interrupts are disabled per increment (the spinlock's
+ *    critical section, none for EventCounter)
+ *  - consuming 1000 events: one locked decrement each vs one drain()
+ */
+#include <Arduino.h>
+#include "event_counter.hpp"
+#include "latency_histogram.hpp"
+
+// Settings
+static const uint32_t num_increments = 100000;
+static const uint32_t num_consumed = 1000;
+enum
+{
+    GO_BIT = 1 << 0,
+};
+
+// Globals
+static volatile uint32_t locked_counter = 0;
+static portMUX_TYPE spinlock = portMUX_INITIALIZER_UNLOCKED;
+static EventCounter event_counter;
+static LatencyHistogram irq_off;
+static SemaphoreHandle_t done_sem;
+static EventGroupHandle_t start_group; // GO_BIT releases the increment tasks
+static volatile bool stop = false;
+static volatile uint32_t cycles[portNUM_PROCESSORS];
+
+//*****************************************************************************
+// Functions that can be called from anywhere (in this file)
+
+static inline void lockedIncrement()
+{
+    portENTER_CRITICAL(&spinlock);
+    locked_counter++;
+    portEXIT_CRITICAL(&spinlock);
+}
+
+// Returns cycles per increment on the calling core
+static float incrementLoop(bool locked)
+{
+    uint32_t start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < num_increments; i++)
+    {
+        if (locked)
+        {
+            lockedIncrement();
+        }
+        else
+        {
+            event_counter.add();
+        }
+    }
+    return (float)(ESP.getCycleCount() - start) / num_increments;
+}
+
+//*****************************************************************************
+// Tasks
+
+// Increments num_increments times on its core once GO_BIT is set. Blocks
+// until then, so it doesn't starve setup() or the idle task on its core.
+void incrementTask(void *parameters)
+{
+    bool locked = (uintptr_t)parameters != 0;
+    xEventGroupWaitBits(start_group, GO_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+    cycles[xPortGetCoreID()] = (uint32_t)(incrementLoop(locked) * 100);
+    xSemaphoreGive(done_sem);
+    vTaskDelete(NULL);
+}
+
+// Keeps the spinlock busy from the other core
+void contenderTask(void *parameters)
+{
+    while (!stop)
+    {
+        lockedIncrement();
+    }
+    xSemaphoreGive(done_sem);
+    vTaskDelete(NULL);
+}
+
+//*****************************************************************************
+// Main
+
+static void benchBothCores(bool locked)
+{
+    xEventGroupClearBits(start_group, GO_BIT);
+    for (BaseType_t core = 0; core < portNUM_PROCESSORS; core++)
+    {
+        xTaskCreatePinnedToCore(incrementTask, "Increment", 2048, (void *)(uintptr_t)locked, 2, NULL, core);
+    }
+
+    // Wakes both tasks at once
+    xEventGroupSetBits(start_group, GO_BIT);
+    for (int core = 0; core < portNUM_PROCESSORS; core++)
+    {
+        xSemaphoreTake(done_sem, portMAX_DELAY);
+    }
+    Serial.printf("%-13s | both cores | %6.2f | %6.2f cycles/increment\r\n",
+                  locked ? "spinlock" : "EventCounter",
+                  cycles[0] / 100.0f, cycles[1] / 100.0f);
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    delay(1000); // for UART connection
+    Serial.println();
+    Serial.println("---Event Counter Benchmark---");
+
+    done_sem = xSemaphoreCreateCounting(portNUM_PROCESSORS, 0);
+    start_group = xEventGroupCreate();
+
+    // One core
+    Serial.printf("%-13s | one core   | %6.2f cycles/increment\r\n", "spinlock", incrementLoop(true));
+    Serial.printf("%-13s | one core   | %6.2f cycles/increment\r\n", "EventCounter", incrementLoop(false));
+
+    // Both cores on the same counter
+    benchBothCores(true);
+    benchBothCores(false);
+    Serial.printf("totals: spinlock %u, EventCounter %u (expected %u each)\r\n",
+                  locked_counter,
+                  event_counter.drain(),
+                  num_increments * (1 + portNUM_PROCESSORS));
+
+    // Interrupts are off from entering to leaving the critical section,
+    // including spinning while the other core holds the lock
+    stop = false;
+    xTaskCreatePinnedToCore(contenderTask, "Contender", 2048, NULL, 2, NULL, 1 - xPortGetCoreID());
+    vTaskDelay(pdMS_TO_TICKS(10));
+    for (uint32_t i = 0; i < num_increments; i++)
+    {
+        uint32_t start = ESP.getCycleCount();
+        lockedIncrement();
+        irq_off.record(ESP.getCycleCount() - start);
+    }
+    stop = true;
+    xSemaphoreTake(done_sem, portMAX_DELAY);
+    irq_off.print("spinlock IRQ off", "cycles");
+    Serial.println("EventCounter IRQ off: never (atomic add)");
+
+    // Consume a batch of events
+    locked_counter = num_consumed;
+    uint32_t start = ESP.getCycleCount();
+    while (locked_counter > 0)
+    {
+        portENTER_CRITICAL(&spinlock);
+        locked_counter--;
+        portEXIT_CRITICAL(&spinlock);
+    }
+    uint32_t per_item = ESP.getCycleCount() - start;
+
+    event_counter.add(num_consumed);
+    start = ESP.getCycleCount();
+    uint32_t drained = event_counter.drain();
+    uint32_t batch = ESP.getCycleCount() - start;
+    Serial.printf("consume %u events: spinlock decrements %u cycles, drain() %u cycles (got %u)\r\n",
+                  num_consumed, per_item, batch, drained);
+    Serial.println("Done!");
+}
+
+void loop()
+{
+    delay(1000); // for the simulator UI
+}
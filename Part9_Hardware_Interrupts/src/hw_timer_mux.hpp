@@ -0,0 +1,236 @@
+/**
+ * Many periodic and one-shot ISR callbacks on one hardware timer
+ *
+ * periodicHWTimer() uses up one of the four ESP32 hardware timers per job.
+ * HWTimerMux runs the timer freely at 1 MHz and keeps a small table of
+ * deadlines instead:
+ *  - the alarm is programmed for the earliest deadline only
+ *  - on the interrupt, every callback that is due runs in that same ISR,
+ *    periodic ones are moved on by their period (from the deadline, so no
+ *    drift) and the alarm is reprogrammed for the next deadline
+ *  - nothing due, no interrupts: the alarm is switched off
+ *
+ * Callbacks run in ISR context like with periodicHWTimer, so they must be
+ * IRAM_ATTR and short: they delay every other callback due at the same time.
+ * They may add or cancel callbacks (e.g. re-arm a one-shot). The table is
+ * fixed size (MAX_CALLBACKS), nothing is allocated.
+ *
+ * The ids periodic() and oneShot() return carry a generation count along
+ * with the table slot, so cancelling a one-shot that already ran can't hit
+ * a later callback that reused its slot.
+ *
+ * An alarm written for a count the timer has already passed never fires, so
+ * alarms are set at least MIN_LEAD ticks ahead and checked once armed. A
+ * deadline closer than that runs up to MIN_LEAD us late.
+ */
+#pragma once
+#include <Arduino.h>
+
+class HWTimerMux
+{
+public:
+    typedef void (*IsrCallback)();
+
+    enum
+    {
+        MAX_CALLBACKS = 16,
+        NUM_TIMERS = 4,             // ESP32 hardware timers
+        TICKS_PER_MS = 1000,        // 80 MHz / 80 = 1 MHz
+        SLOT_BITS = 8,              // Low bits of an id: table slot
+        GENERATION_MASK = 0x7FFFFF, // High bits: slot reuse count, id >= 0
+        MIN_LEAD = 10,              // Ticks between now and an alarm
+    };
+
+    // Take hardware timer number and start it counting
+    bool begin(uint8_t number)
+    {
+        // timerAttachInterrupt takes a plain function, so one entry per timer
+        static void (*const isr_entries[NUM_TIMERS])() = {
+            isrEntry<0>, isrEntry<1>, isrEntry<2>, isrEntry<3>};
+
+        if (number >= NUM_TIMERS || instances()[number] != NULL)
+        {
+            return false;
+        }
+        instances()[number] = this;
+        timer = timerBegin(number, 80, true); // 80 / 80 = 1 MHz
+        timerAttachInterrupt(timer, isr_entries[number], true);
+        return true;
+    }
+
+    // Call isrCallback every ms milliseconds. Returns an id for cancel(), or
+    // -1 if the table is full or ms is 0. Safe from a callback.
+    int IRAM_ATTR periodic(uint64_t ms, IsrCallback isrCallback)
+    {
+        if (ms == 0)
+        {
+            return -1;
+        }
+        return add(ms * TICKS_PER_MS, ms * TICKS_PER_MS, isrCallback);
+    }
+
+    // Call isrCallback once, ms milliseconds from now. Safe from a callback.
+    int IRAM_ATTR oneShot(uint64_t ms, IsrCallback isrCallback)
+    {
+        return add(ms * TICKS_PER_MS, 0, isrCallback);
+    }
+
+    // Stop a callback (no effect if a one-shot already ran, even if its slot
+    // has been reused since). Safe from a callback.
+    void IRAM_ATTR cancel(int id)
+    {
+        int slot = id & ((1 << SLOT_BITS) - 1);
+        uint32_t generation = (uint32_t)id >> SLOT_BITS;
+        if (id < 0 || slot >= MAX_CALLBACKS)
+        {
+            return;
+        }
+        portENTER_CRITICAL_SAFE(&lock);
+        if (entries[slot].generation == generation)
+        {
+            entries[slot].callback = NULL;
+        }
+        portEXIT_CRITICAL_SAFE(&lock);
+    }
+
+    // Interrupts taken so far (each may run several callbacks)
+    uint32_t getInterruptCount() const
+    {
+        return interrupts;
+    }
+
+private:
+    struct Entry
+    {
+        IsrCallback callback; // NULL = free slot
+        uint64_t deadline;    // Timer count
+        uint64_t period;      // 0 = one-shot
+        uint32_t generation;  // Times the slot has been taken
+    };
+
+    int IRAM_ATTR add(uint64_t delay, uint64_t period, IsrCallback isrCallback)
+    {
+        int id = -1;
+        portENTER_CRITICAL_SAFE(&lock);
+        for (int i = 0; i < MAX_CALLBACKS; i++)
+        {
+            if (entries[i].callback == NULL)
+            {
+                entries[i].generation = (entries[i].generation + 1) & GENERATION_MASK;
+                id = (int)(entries[i].generation << SLOT_BITS) | i;
+                entries[i].deadline = timerRead(timer) + delay;
+                entries[i].period = period;
+                entries[i].callback = isrCallback;
+                added = true;
+                if (entries[i].deadline < next_alarm)
+                {
+                    program(entries[i].deadline);
+                }
+                break;
+            }
+        }
+        portEXIT_CRITICAL_SAFE(&lock);
+        return id;
+    }
+
+    // Run everything due, then aim the alarm at the next deadline
+    inline void IRAM_ATTR fire()
+    {
+        portENTER_CRITICAL_ISR(&lock);
+        interrupts++;
+        uint64_t now = timerRead(timer);
+        uint64_t next;
+        while (1)
+        {
+            added = false;
+            next = UINT64_MAX;
+            for (int i = 0; i < MAX_CALLBACKS; i++)
+            {
+                Entry &entry = entries[i];
+                if (entry.callback == NULL)
+                {
+                    continue;
+                }
+                if (entry.deadline <= now)
+                {
+                    IsrCallback callback = entry.callback;
+                    if (entry.period != 0)
+                    {
+                        entry.deadline += entry.period;
+                        if (entry.deadline <= now)
+                        {
+                            // Fell more than a period behind: skip, don't burst
+                            entry.deadline = now + entry.period;
+                        }
+                    }
+                    else
+                    {
+                        entry.callback = NULL;
+                    }
+                    callback();
+                }
+                if (entry.callback != NULL && entry.deadline < next)
+                {
+                    next = entry.deadline;
+                }
+            }
+
+            // Callbacks take time: if the next deadline passed meanwhile, go
+            // round again rather than set an alarm in the past. Same if a
+            // callback added one (the scan may have passed its slot).
+            now = timerRead(timer);
+            if (next > now && !added)
+            {
+                break;
+            }
+        }
+        next_alarm = UINT64_MAX;
+        if (next != UINT64_MAX)
+        {
+            program(next);
+        }
+        portEXIT_CRITICAL_ISR(&lock);
+    }
+
+    // Set a one-time alarm at count deadline, or MIN_LEAD ticks from now if
+    // that's later (lock held). If the count passed the alarm while it was
+    // being written, try again further ahead.
+    inline void IRAM_ATTR program(uint64_t deadline)
+    {
+        while (1)
+        {
+            uint64_t earliest = timerRead(timer) + MIN_LEAD;
+            if (deadline < earliest)
+            {
+                deadline = earliest;
+            }
+            next_alarm = deadline;
+            timerAlarmWrite(timer, deadline, false);
+            timerAlarmEnable(timer);
+            if (timerRead(timer) < deadline)
+            {
+                break;
+            }
+        }
+    }
+
+    template <uint8_t N>
+    static void IRAM_ATTR isrEntry()
+    {
+        instances()[N]->fire();
+    }
+
+    // Which object each hardware timer's ISR is bound to
+    static inline HWTimerMux **IRAM_ATTR instances()
+    {
+        static HWTimerMux *bound[NUM_TIMERS] = {};
+        return bound;
+    }
+
+    hw_timer_t *timer = NULL;
+    Entry entries[MAX_CALLBACKS] = {};
+    uint64_t next_alarm = UINT64_MAX; // Alarm currently programmed
+    bool added = false;               // add() ran during fire()
+    volatile uint32_t interrupts = 0;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+};
@@ -0,0 +1,331 @@
+/**
+ * ESP32 Audio RMS with packed sample buffers
+ *
+ * Port of Part9_codes/esp32-freertos-09-solution-isr-audio.ino: sample the
+ * ADC at 16 kHz in an ISR, compute the RMS voltage of each block in a task
+ * and show it on a PWM LED. The double buffer stores 12-bit samples packed
+ * two per three bytes, so the 6.4 KB that held 2 x 1600 uint16_t samples now
+ * holds 2 x 2132 samples (133 ms windows instead of 100 ms).
+ *
+ * Type "rms" in the terminal to print the latest value, "isr" for the ADC
+ * ISR's execution time and period jitter (build with -D ISR_PROFILING),
+ * "jitter" for the CLI loop's release jitter and overruns.
+ */
+#include <Arduino.h>
+#include "packed_samples.hpp"
+#include "isr_profiler.hpp"
+#include "periodic_task.hpp"
+
+static const BaseType_t app_cpu = 1;
+
+// Settings
+static const char command[] = "rms";           // Command
+static const char isr_command[] = "isr";       // Print ISR profile
+static const char jitter_command[] = "jitter"; // Print CLI loop jitter
+static const float sample_period_us = 62.5;    // 16kHz sample rate
+static const uint16_t timer_divider = 2;       // Divide 80 MHz by this
+static const uint64_t timer_max_count = 2500;  // 16kHz sample rate
+static const uint32_t cli_delay = 10;          // ms delay
+static const float adc_voltage = 3.3;          // Max ADC voltage
+static const uint16_t adc_max = 4095;          // Max ADC value (12-bit)
+static const uint8_t pwm_ch = 0;               // PWM channel
+enum
+{
+    BUF_LEN = 2132,    // Samples per buffer (same RAM as 1600 x uint16_t)
+    CHUNK_LEN = 64,    // Samples unpacked at a time for processing
+    MSG_LEN = 100,     // Max characters in message body
+    MSG_QUEUE_LEN = 5, // Number of slots in message queue
+    CMD_BUF_LEN = 255, // Number of characters in command buffer
+};
+
+// Pins
+static const int adc_pin = A0;
+static const int led_pin = 15;
+
+// Message struct to wrap strings for queue
+struct Message
+{
+    char body[MSG_LEN];
+};
+
+typedef PackedSamples12<BUF_LEN> SampleBuffer;
+
+// Globals
+static hw_timer_t *timer = NULL;
+static TaskHandle_t processing_task = NULL;
+static SemaphoreHandle_t sem_done_reading = NULL;
+static portMUX_TYPE spinlock = portMUX_INITIALIZER_UNLOCKED;
+static QueueHandle_t msg_queue;
+static SampleBuffer buf_0;                   // One buffer in the pair
+static SampleBuffer buf_1;                   // The other buffer in the pair
+static SampleBuffer *volatile write_to = &buf_0;  // Double buffer write pointer
+static SampleBuffer *volatile read_from = &buf_1; // Double buffer read pointer
+static volatile uint8_t buf_overrun = 0;     // Double buffer overrun flag
+static float adc_rms;
+static IsrProfiler adc_isr_profile;          // onTimer execution and jitter
+static PeriodicTask cli_period;              // CLI loop, no drift
+
+//*****************************************************************************
+// Interrupt Service Routines (ISRs)
+
+// This function executes when timer reaches max (and resets)
+void IRAM_ATTR onTimer()
+{
+    ISR_PROFILE(adc_isr_profile);
+    static uint16_t idx = 0;
+    BaseType_t task_woken = pdFALSE;
+
+    // If buffer is not overrun, read ADC to next buffer element. If buffer is
+    // overrun, drop the sample.
+    if ((idx < BUF_LEN) && (buf_overrun == 0))
+    {
+        write_to->set(idx, analogRead(adc_pin));
+        idx++;
+    }
+
+    // Check if the buffer is full
+    if (idx >= BUF_LEN)
+    {
+        // If reading is not done, set overrun flag. We don't need to set this
+        // as a critical section, as nothing can interrupt and change either value.
+        if (xSemaphoreTakeFromISR(sem_done_reading, &task_woken) == pdFALSE)
+        {
+            buf_overrun = 1;
+        }
+
+        // Only swap buffers and notify task if overrun flag is cleared
+        if (buf_overrun == 0)
+        {
+            // Reset index and swap buffer pointers
+            idx = 0;
+            SampleBuffer *tmp = write_to;
+            write_to = read_from;
+            read_from = tmp;
+            // A task notification works like a binary semaphore but is faster
+            vTaskNotifyGiveFromISR(processing_task, &task_woken);
+        }
+    }
+
+    // Exit from ISR (ESP-IDF)
+    if (task_woken)
+    {
+        portYIELD_FROM_ISR();
+    }
+}
+
+//*****************************************************************************
+// Tasks
+
+// Serial terminal task
+void doCLI(void *parameters)
+{
+    Message rcv_msg;
+    char c;
+    char cmd_buf[CMD_BUF_LEN];
+    uint8_t idx = 0;
+
+    // Clear whole buffer
+    memset(cmd_buf, 0, CMD_BUF_LEN);
+
+    cli_period.begin(cli_delay / portTICK_PERIOD_MS);
+
+    // Loop forever
+    while (1)
+    {
+        // Look for any error messages that need to be printed
+        if (xQueueReceive(msg_queue, (void *)&rcv_msg, 0) == pdTRUE)
+        {
+            Serial.println(rcv_msg.body);
+        }
+
+        // Read characters from serial
+        if (Serial.available() > 0)
+        {
+            c = Serial.read();
+
+            // Store received character to buffer if not over buffer limit
+            if (idx < CMD_BUF_LEN - 1)
+            {
+                cmd_buf[idx] = c;
+                idx++;
+            }
+
+            // Print newline and check input on 'enter'
+            if ((c == '\n') || (c == '\r'))
+            {
+                // Print newline to terminal
+                Serial.print("\r\n");
+
+                // Print RMS value if command given is "rms"
+                cmd_buf[idx - 1] = '\0';
+                if (strcmp(cmd_buf, command) == 0)
+                {
+                    Serial.print("RMS Voltage: ");
+                    Serial.println(adc_rms);
+                }
+                else if (strcmp(cmd_buf, isr_command) == 0)
+                {
+                    adc_isr_profile.print("onTimer");
+                    Serial.printf("  budget %.1f us\r\n", sample_period_us);
+                    adc_isr_profile.reset();
+                }
+                else if (strcmp(cmd_buf, jitter_command) == 0)
+                {
+                    cli_period.print("CLI loop jitter");
+                }
+
+                // Reset receive buffer and index counter
+                memset(cmd_buf, 0, CMD_BUF_LEN);
+                idx = 0;
+            }
+            else
+            {
+                // Otherwise, echo character back to serial terminal
+                Serial.print(c);
+            }
+        }
+
+        // Don't hog the CPU. Yield to other tasks for a while
+        cli_period.wait();
+    }
+}
+
+// Wait for semaphore and calculate RMS of ADC values
+void calcRMS(void *parameters)
+{
+    Message msg;
+    uint16_t chunk[CHUNK_LEN];
+    float avg;
+    float rms;
+    float brightness;
+
+    // Loop forever, wait for semaphore, and print value
+    while (1)
+    {
+        // Wait for notification from ISR (similar to binary semaphore)
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        const SampleBuffer *samples = read_from;
+
+        // Calculate average (in ADC counts), one unpacked chunk at a time
+        avg = 0.0;
+        for (int i = 0; i < BUF_LEN; i += CHUNK_LEN)
+        {
+            int len = std::min((int)CHUNK_LEN, BUF_LEN - i);
+            samples->unpack(i, len, chunk);
+            for (int j = 0; j < len; j++)
+            {
+                avg += (float)chunk[j];
+            }
+        }
+        avg /= BUF_LEN;
+
+        // Calculate RMS around the average (filter out DC component)
+        rms = 0.0;
+        for (int i = 0; i < BUF_LEN; i += CHUNK_LEN)
+        {
+            int len = std::min((int)CHUNK_LEN, BUF_LEN - i);
+            samples->unpack(i, len, chunk);
+            for (int j = 0; j < len; j++)
+            {
+                float diff = (float)chunk[j] - avg;
+                rms += diff * diff;
+            }
+        }
+        rms = sqrtf(rms / BUF_LEN);
+
+        // Convert to volts
+        rms = (rms * adc_voltage) / (float)adc_max;
+
+        // Update LED brightness
+        brightness = (rms * UINT16_MAX) / adc_voltage;
+        ledcWrite(pwm_ch, brightness);
+
+        // Updating the shared float may or may not take multiple instructions, so
+        // we protect it with a mutex or critical section. The ESP-IDF critical
+        // section is the easiest for this application.
+        portENTER_CRITICAL(&spinlock);
+        adc_rms = rms;
+        portEXIT_CRITICAL(&spinlock);
+
+        // If we took too long to process, buffer writing will have overrun. So,
+        // we send a message to be printed out to the serial terminal.
+        if (buf_overrun == 1)
+        {
+            strcpy(msg.body, "Error: Buffer overrun. Samples have been dropped.");
+            xQueueSend(msg_queue, (void *)&msg, 10);
+        }
+
+        // Clearing the overrun flag and giving the "done reading" semaphore must
+        // be done together without being interrupted.
+        portENTER_CRITICAL(&spinlock);
+        buf_overrun = 0;
+        xSemaphoreGive(sem_done_reading);
+        portEXIT_CRITICAL(&spinlock);
+    }
+}
+
+//*****************************************************************************
+// Main (runs as its own task with priority 1 on core 1)
+
+void setup()
+{
+    // Configure PWM pin
+    pinMode(led_pin, OUTPUT);
+    ledcAttachPin(led_pin, pwm_ch); // Assign pin to PWM channel 0
+    ledcSetup(pwm_ch, 4000, 16);    // channel 0, 4kHz, 16-bit resolution
+
+    // Configure Serial
+    Serial.begin(115200);
+    // Wait a moment to start (so we don't miss Serial output)
+    vTaskDelay(1000 / portTICK_PERIOD_MS);
+    Serial.println();
+    Serial.println("---FreeRTOS Audio RMS Demo (packed samples)---");
+    Serial.printf("Sample memory: %u bytes for 2 x %u samples\r\n",
+                  (unsigned)(sizeof(buf_0) + sizeof(buf_1)), (unsigned)BUF_LEN);
+
+    // Create semaphore before it is used (in task or ISR)
+    sem_done_reading = xSemaphoreCreateBinary();
+    // Force reboot if we can't create the semaphore
+    if (sem_done_reading == NULL)
+    {
+        Serial.println("Could not create one or more semaphores");
+        ESP.restart();
+    }
+
+    // We want the done reading semaphore to initialize to 1
+    xSemaphoreGive(sem_done_reading);
+
+    // Create message queue before it is used
+    msg_queue = xQueueCreate(MSG_QUEUE_LEN, sizeof(Message));
+
+    // Start task to handle command line interface events. Let's set it at a
+    // higher priority but only run it once every 10 ms.
+    xTaskCreatePinnedToCore(doCLI,
+                            "Do CLI",
+                            2048,
+                            NULL,
+                            2,
+                            NULL,
+                            app_cpu);
+
+    // Start task to calculate RMS. Save handle for use with notifications.
+    xTaskCreatePinnedToCore(calcRMS,
+                            "Calculate RMS",
+                            2048,
+                            NULL,
+                            1,
+                            &processing_task,
+                            app_cpu);
+
+    // Start a timer to run ISR at 16 kHz
+    adc_isr_profile.begin(sample_period_us);
+    timer = timerBegin(0, timer_divider, true);
+    timerAttachInterrupt(timer, &onTimer, true);
+    timerAlarmWrite(timer, timer_max_count, true);
+    timerAlarmEnable(timer);
+}
+
+void loop()
+{
+    delay(10); // for simulator UI
+}
@@ -3,6 +3,8 @@
  * ESP32 ISR Critical Section Demo
  *
  * Increment global variable in ISR.
+ * The counter is an EventCounter: the ISR adds without a spinlock and the
+ * task takes everything counted so far in one drain().
  * Date: Feb. 3, 2021
  * Author: Shawn Hymel
  * https://github.com/ShawnHymel/introduction-to-rtos/blob/main/09-hardware-interrupts/esp32-freertos-09-demo-isr-critical-section/esp32-freertos-09-demo-isr-critical-section.ino
@@ -10,6 +12,7 @@
  */
 
 #include <Arduino.h>
+#include "event_counter.hpp"
 
 static const BaseType_t app_cpu = 1; // Application CPU
 
@@ -19,29 +22,25 @@ static const uint32_t timer_max_count = 1000000;                // 10MHz / 1 = 1
 static const TickType_t task_delay = 2000 / portTICK_PERIOD_MS; // 2000 ms
 
 // Globals
-static hw_timer_t *timer = NULL;                             // Timer object
-static volatile uint32_t isr_counter;                        // Counter incremented in ISR
-static portMUX_TYPE spinlock = portMUX_INITIALIZER_UNLOCKED; // Spinlock
+static hw_timer_t *timer = NULL; // Timer object
+static EventCounter isr_counter; // Counter incremented in ISR
 
 void IRAM_ATTR onTimer()
 {
     // Increment counter
-    portENTER_CRITICAL_ISR(&spinlock);
-    isr_counter++;
-    portEXIT_CRITICAL_ISR(&spinlock);
+    isr_counter.add();
 }
 
 void printValue(void *pvParameters)
 {
     while (1)
     {
-        while (isr_counter > 0)
+        // Take the whole batch at once, then count it down
+        uint32_t pending = isr_counter.drain();
+        while (pending > 0)
         {
-            Serial.println(isr_counter);
-
-            portENTER_CRITICAL(&spinlock);
-            isr_counter--;
-            portEXIT_CRITICAL(&spinlock);
+            Serial.println(pending);
+            pending--;
         }
         Serial.println("ISR incrementing counter...");
         vTaskDelay(task_delay); // wait 2 seconds while ISR increments counter a few times
@@ -0,0 +1,122 @@
+/**
+ * ISR execution time and period jitter profiler
+ *
+ * Put ISR_PROFILE(profiler) at the top of an ISR. From the CPU cycle counter
+ * it records, per ISR:
+ *  - execution time: entry to exit, in cycles
+ *  - jitter: how far the time between two entries is from the nominal
+ *    period given to begin(), in cycles
+ * into fixed-size histograms (min/max/percentiles). The ISR does two counter
+ * reads and two histogram updates (some tens of cycles), nothing else.
+ *
+ * print() copies the histograms with interrupts off, so call it from a task
+ * on the core the ISR runs on.
+ *
+ * Without -D ISR_PROFILING the macro expands to nothing and IsrProfiler is
+ * an empty shell, so profiled ISRs compile exactly as before.
+ */
+#pragma once
+#include <Arduino.h>
+
+#ifdef ISR_PROFILING
+#include "latency_histogram.hpp"
+
+class IsrProfiler
+{
+public:
+    // Nominal time between interrupts, 0 = not periodic (no jitter)
+    void begin(float period_us)
+    {
+        period_cycles = (uint32_t)(period_us * ESP.getCpuFreqMHz());
+    }
+
+    void print(const char *name)
+    {
+        LatencyHistogram exec_copy;
+        LatencyHistogram jitter_copy;
+        portENTER_CRITICAL(&lock);
+        exec_copy = exec;
+        jitter_copy = jitter;
+        portEXIT_CRITICAL(&lock);
+
+        uint32_t mhz = ESP.getCpuFreqMHz();
+        Serial.printf("ISR %s (%u cycles per us):\r\n", name, mhz);
+        exec_copy.print("  execution", "cycles");
+        if (period_cycles != 0)
+        {
+            jitter_copy.print("  period jitter", "cycles");
+        }
+        Serial.printf("  worst execution %.2f us\r\n", (float)exec_copy.getMax() / mhz);
+    }
+
+    void reset()
+    {
+        portENTER_CRITICAL(&lock);
+        exec.reset();
+        jitter.reset();
+        last_entry = 0;
+        portEXIT_CRITICAL(&lock);
+    }
+
+    // Records one ISR run from construction to destruction
+    class Scope
+    {
+    public:
+        inline Scope(IsrProfiler &profiler)
+            : profiler(profiler), entry(ESP.getCycleCount())
+        {
+        }
+
+        inline ~Scope()
+        {
+            profiler.record(entry, ESP.getCycleCount());
+        }
+
+    private:
+        IsrProfiler &profiler;
+        uint32_t entry;
+    };
+
+private:
+    inline void IRAM_ATTR record(uint32_t entry, uint32_t exit)
+    {
+        exec.record(exit - entry);
+        if (period_cycles != 0 && last_entry != 0)
+        {
+            int32_t deviation = (int32_t)(entry - last_entry - period_cycles);
+            jitter.record(deviation < 0 ? -deviation : deviation);
+        }
+        last_entry = entry;
+    }
+
+    LatencyHistogram exec;
+    LatencyHistogram jitter;
+    uint32_t period_cycles = 0;
+    uint32_t last_entry = 0;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+};
+
+#define ISR_PROFILE(profiler) IsrProfiler::Scope isr_profile_scope(profiler)
+
+#else
+
+class IsrProfiler
+{
+public:
+    void begin(float period_us)
+    {
+    }
+
+    void print(const char *name)
+    {
+        Serial.printf("ISR %s: profiling off (build with -D ISR_PROFILING)\r\n", name);
+    }
+
+    void reset()
+    {
+    }
+};
+
+#define ISR_PROFILE(profiler)
+
+#endif
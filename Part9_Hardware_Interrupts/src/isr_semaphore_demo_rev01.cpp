@@ -5,40 +5,38 @@
  * rev01:
  * - Using periodicHWTimer in the utilities.hpp
  * - Using taskNotification instead of Semaphore
+ * - Using DeferredInterrupt for the ISR/task binding
  */
 
 #include <Arduino.h>
-#include "utilities.hpp"
+#include "deferred_interrupt.hpp"
 
 static const BaseType_t app_cpu = 1; // Application CPU
 static const uint8_t adc_pin = A0;   // ADC pin (36)
 
+enum
+{
+    EVENT_ADC = 1 << 0, // New ADC value
+};
+
 // Globals
 static volatile uint32_t adc_val;
-static TaskHandle_t print_task = NULL;
+static DeferredInterrupt adc_event;
 
-void IRAM_ATTR onTimer()
+uint32_t IRAM_ATTR onTimer()
 {
-    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
     // Perform action (read ADC)
     adc_val = analogRead(adc_pin);
-
-    vTaskNotifyGiveFromISR(print_task, &xHigherPriorityTaskWoken);
-    // Exit from ISR (ESP-IDF)
-    if (xHigherPriorityTaskWoken)
-    {
-        portYIELD_FROM_ISR();
-    }
+    return EVENT_ADC;
 }
 
-void printValue(void *pvParameters)
+void printValue(uint32_t bits, uint32_t missed)
 {
-    while (1)
+    // Print value
+    Serial.println(adc_val);
+    if (missed > 0)
     {
-        // Wait for notification from ISR
-        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-        // Print value
-        Serial.println(adc_val);
+        Serial.printf("(%u values not printed)\r\n", missed);
     }
 }
 
@@ -47,20 +45,12 @@ void setup()
     Serial.begin(115200);
     delay(1000);
     Serial.println("---FreeRTOS ISR Semaphore Demo---");
-    // Create task
-    xTaskCreatePinnedToCore(printValue,
-                            "PrintValue",
-                            2048,
-                            NULL,
-                            2,
-                            &print_task,
-                            app_cpu);
 
-    // Set up timer
-    periodicHWTimer(0, 1000, &onTimer);
+    // Create task and set up timer
+    adc_event.begin(0, 1000, onTimer, printValue, "PrintValue", 2048, 2, app_cpu);
 }
 
 void loop()
 {
     delay(10); // for simulator UI
-}
\ No newline at end of file
+}
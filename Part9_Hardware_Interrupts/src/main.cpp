@@ -2,6 +2,7 @@
  * ESP32 Sample and Process Solution
  *
  * Sample ADC in an ISR, process in a task.
+ * Every 10th report also prints the CLI loop's release jitter.
  *
  * Date: February 3, 2021
  * Author: Shawn Hymel
@@ -10,9 +11,13 @@
 #include <Arduino.h>
 static const BaseType_t app_cpu = 1;
 #include "utilities.hpp"
+#include "measurement.hpp"
+#include "snapshot.hpp"
+#include "periodic_task.hpp"
 
 // Settings
 static const uint32_t cli_delay = 1000; // ms delay
+static const uint32_t report_every = 10; // CLI loops between jitter reports
 static const uint8_t adc_pin = A0;     // GPIO 36U
 
 enum
@@ -39,7 +44,8 @@ static volatile uint16_t buf_1[BUF_LEN];     // The other buffer in the pair
 static volatile uint16_t *write_to = buf_0;  // Double buffer write pointer
 static volatile uint16_t *read_from = buf_1; // Double buffer read pointer
 static volatile uint8_t buf_overrun = 0;     // Double buffer overrun flag
-static float adc_avg;
+static Snapshot<Measurement> adc_meas;       // Latest block measurement
+static PeriodicTask cli_period;              // CLI loop, no drift
 
 //*****************************************************************************
 // Functions that can be called from anywhere (in this file)
@@ -99,6 +105,7 @@ void doCLI(void *parameters)
 {
     Message err_msg;
 
+    cli_period.begin(cli_delay / portTICK_PERIOD_MS);
     while (1)
     {
         // Looking for any error messages that need to be printed
@@ -106,30 +113,34 @@ void doCLI(void *parameters)
         {
             Serial.println(err_msg.body);
         }
-        Serial.print("Average: ");
-        Serial.println(adc_avg);
-        vTaskDelay(cli_delay / portTICK_PERIOD_MS);
+        // One consistent copy of all fields, no lock needed
+        Measurement m = adc_meas.read();
+        Serial.printf("Block %u: average %.1f, RMS %.1f, min %u, max %u\r\n",
+                      m.seq, m.mean, m.rms, m.min, m.max);
+        if (cli_period.getReleases() % report_every == report_every - 1)
+        {
+            cli_period.print("CLI loop jitter");
+        }
+        cli_period.wait();
     }
 }
 
-// Wait for semaphore and calculate average of ADC values
+// Wait for semaphore and measure the block of ADC values
 void calcAverage(void *parameters)
 {
     Message msg;
-    float avg;
+    uint32_t seq = 0;
 
     // Loop forever, wait for semaphore, and print value
     while (1)
     {
         // Wait for notification from ISR (similar to binary semaphore)
         ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-        avg = average((uint16_t *)read_from, BUF_LEN); // processing can take long time in practice --> buffer overrun
-        // Updating the shared float may or may not take multiple instructions, so
-        // we protect it with a mutex or critical section. The ESP-IDF critical
-        // section is the easiest for this application.
-        portENTER_CRITICAL(&spinlock);
-        adc_avg = avg;
-        portEXIT_CRITICAL(&spinlock);
+        // processing can take long time in practice --> buffer overrun
+        Measurement m = measureBlock((uint16_t *)read_from, BUF_LEN, ++seq);
+        // Publish all fields at once. Readers retry instead of us disabling
+        // interrupts, so the ISR is never held off by the publish.
+        adc_meas.publish(m);
 
         // If we took too long to process, buffer writing will have overrun. So,
         // we send a message to be printed out to the serial terminal.
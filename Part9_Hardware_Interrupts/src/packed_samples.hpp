@@ -0,0 +1,84 @@
+/**
+ * Packed 12-bit sample buffer
+ *
+ * The ADC gives 12-bit values, so a uint16_t buffer wastes a quarter of its
+ * memory. PackedSamples12 stores two samples in three bytes:
+ *
+ *   byte 0: a[7:0]    byte 1: b[3:0] a[11:8]    byte 2: b[11:4]
+ *
+ * The ISR writes one sample at a time with set(). The processing task pulls
+ * blocks out with unpack() into a small uint16_t scratch array and runs the
+ * usual kernels on that, so only the scratch array is unpacked at any time.
+ */
+#pragma once
+#include <Arduino.h>
+
+template <uint32_t LEN>
+class PackedSamples12
+{
+    static_assert(LEN % 2 == 0, "LEN must be even");
+
+public:
+    enum
+    {
+        length = LEN,
+        bytes = LEN / 2 * 3,
+    };
+
+    // Store one sample (only the low 12 bits are kept). Called from the ISR.
+    inline __attribute__((always_inline)) void set(uint32_t idx, uint16_t val)
+    {
+        uint8_t *p = &data[idx / 2 * 3];
+        if ((idx & 1) == 0)
+        {
+            p[0] = val & 0xFF;
+            p[1] = (p[1] & 0xF0) | ((val >> 8) & 0x0F);
+        }
+        else
+        {
+            p[1] = (p[1] & 0x0F) | ((val & 0x0F) << 4);
+            p[2] = (val >> 4) & 0xFF;
+        }
+    }
+
+    uint16_t get(uint32_t idx) const
+    {
+        const uint8_t *p = &data[idx / 2 * 3];
+        if ((idx & 1) == 0)
+        {
+            return p[0] | ((p[1] & 0x0F) << 8);
+        }
+        return (p[1] >> 4) | (p[2] << 4);
+    }
+
+    // Unpack count samples starting at start into dst
+    void unpack(uint32_t start, uint32_t count, uint16_t *dst) const
+    {
+        uint32_t end = start + count;
+        if (start & 1)
+        {
+            *dst++ = get(start++);
+        }
+
+        // Two samples per three bytes, no branches
+        const uint8_t *p = &data[start / 2 * 3];
+        for (; start + 1 < end; start += 2)
+        {
+            uint8_t b0 = p[0];
+            uint8_t b1 = p[1];
+            uint8_t b2 = p[2];
+            dst[0] = b0 | ((b1 & 0x0F) << 8);
+            dst[1] = (b1 >> 4) | (b2 << 4);
+            dst += 2;
+            p += 3;
+        }
+
+        if (start < end)
+        {
+            *dst = get(start);
+        }
+    }
+
+private:
+    uint8_t data[bytes];
+};
@@ -0,0 +1,125 @@
+/**
+ * ESP32 Packed Sample Benchmark
+ *
+ * Cost of keeping ADC samples packed (two per three bytes) compared with a
+ * plain uint16_t buffer:
+ *  - ISR side: cycles per stored sample
+ *  - task side: cycles to average a 1600-sample block (unpacked in chunks
+ *    of 64 vs. read directly)
+ * and how long a 16 kHz block may be to fit in the same memory.
+ */
+#include <Arduino.h>
+#include "packed_samples.hpp"
+
+// Settings
+static const uint32_t sample_rate = 16000; // Hz (as in the audio demo)
+static const int num_runs = 100;
+enum
+{
+    BUF_LEN = 1600,
+    CHUNK_LEN = 64,
+};
+
+// Globals
+static uint16_t plain_buf[BUF_LEN];
+static PackedSamples12<BUF_LEN> packed_buf;
+static volatile float sink; // Keeps results from being optimized out
+
+//*****************************************************************************
+// Functions that can be called from anywhere (in this file)
+
+static float averagePlain()
+{
+    float sum = 0.0;
+    for (int i = 0; i < BUF_LEN; i++)
+    {
+        sum += (float)plain_buf[i];
+    }
+    return sum / BUF_LEN;
+}
+
+static float averagePacked()
+{
+    uint16_t chunk[CHUNK_LEN];
+    float sum = 0.0;
+    for (int i = 0; i < BUF_LEN; i += CHUNK_LEN)
+    {
+        int len = std::min((int)CHUNK_LEN, BUF_LEN - i);
+        packed_buf.unpack(i, len, chunk);
+        for (int j = 0; j < len; j++)
+        {
+            sum += (float)chunk[j];
+        }
+    }
+    return sum / BUF_LEN;
+}
+
+//*****************************************************************************
+// Main
+
+void setup()
+{
+    Serial.begin(115200);
+    delay(1000);
+    Serial.println();
+    Serial.println("---Packed 12-bit Sample Benchmark---");
+
+    // Fill both buffers with the same pseudo-random 12-bit samples, timing
+    // the stores the ISR would do
+    uint32_t plain_store = 0;
+    uint32_t packed_store = 0;
+    for (int i = 0; i < BUF_LEN; i++)
+    {
+        uint16_t val = esp_random() & 0xFFF;
+        uint32_t start = ESP.getCycleCount();
+        plain_buf[i] = val;
+        uint32_t mid = ESP.getCycleCount();
+        packed_buf.set(i, val);
+        uint32_t end = ESP.getCycleCount();
+        plain_store += mid - start;
+        packed_store += end - mid;
+    }
+
+    uint32_t plain_cycles = 0;
+    uint32_t packed_cycles = 0;
+    for (int run = 0; run < num_runs; run++)
+    {
+        uint32_t start = ESP.getCycleCount();
+        sink = averagePlain();
+        uint32_t mid = ESP.getCycleCount();
+        sink = averagePacked();
+        uint32_t end = ESP.getCycleCount();
+        plain_cycles += mid - start;
+        packed_cycles += end - mid;
+    }
+    plain_cycles /= num_runs;
+    packed_cycles /= num_runs;
+
+    if (averagePlain() != averagePacked())
+    {
+        Serial.println("Error: packed and plain averages differ!");
+    }
+
+    uint32_t plain_bytes = sizeof(plain_buf);
+    uint32_t packed_bytes = sizeof(packed_buf);
+    uint32_t packed_len = (plain_bytes * 2 / 3) & ~1U; // Samples in the same RAM
+    uint32_t cpu_hz = ESP.getCpuFreqMHz() * 1000000;
+    uint32_t block_cycles = cpu_hz / sample_rate * BUF_LEN; // CPU cycles per block
+    int32_t unpack_cycles = (int32_t)packed_cycles - (int32_t)plain_cycles; // Can be < 0
+
+    Serial.printf("Memory per %u-sample buffer: %u bytes plain, %u bytes packed\r\n",
+                  (unsigned)BUF_LEN, plain_bytes, packed_bytes);
+    Serial.printf("Same RAM as plain holds %u packed samples (%u ms at %u Hz)\r\n",
+                  packed_len, packed_len * 1000 / sample_rate, sample_rate);
+    Serial.printf("Store per sample (cycles): plain %u, packed %u\r\n",
+                  plain_store / BUF_LEN, packed_store / BUF_LEN);
+    Serial.printf("Average of one block (cycles): plain %u, packed %u (%+d)\r\n",
+                  plain_cycles, packed_cycles, (int)unpack_cycles);
+    Serial.printf("Unpack overhead: %.3f%% of the CPU time between blocks\r\n",
+                  100.0 * unpack_cycles / block_cycles);
+}
+
+void loop()
+{
+    delay(10); // for simulator UI
+}
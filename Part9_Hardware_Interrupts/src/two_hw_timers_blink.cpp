@@ -1,5 +1,14 @@
+/**
+ * Blink two LEDs at 500 and 501 ms from one hardware timer
+ *
+ * Both ISR callbacks share timer 0 through HWTimerMux instead of using up
+ * timers 0 and 3 with periodicHWTimer. LED1 is a periodic callback. LED2 is
+ * a one-shot that re-arms itself each time it runs: it counts its 501 ms
+ * from when it ran rather than from its deadline, so unlike LED1 it drifts
+ * by the interrupt latency (microseconds) per blink.
+ */
 #include <Arduino.h>
-#include <utilities.hpp>
+#include "hw_timer_mux.hpp"
 
 enum
 {
@@ -7,6 +16,9 @@ enum
     LED2 = 23,
 };
 
+// Globals
+static HWTimerMux timer_mux;
+
 void IRAM_ATTR onTimer1()
 {
     digitalWrite(LED1, !digitalRead(LED1));
@@ -15,17 +27,19 @@ void IRAM_ATTR onTimer1()
 void IRAM_ATTR onTimer2()
 {
     digitalWrite(LED2, !digitalRead(LED2));
+    timer_mux.oneShot(501, &onTimer2);
 }
 
 void setup()
 {
     pinMode(LED1, OUTPUT);
     pinMode(LED2, OUTPUT);
-    periodicHWTimer(0, 500, &onTimer1);
-    periodicHWTimer(3, 501, &onTimer2);
+    timer_mux.begin(0);
+    timer_mux.periodic(500, &onTimer1);
+    timer_mux.oneShot(501, &onTimer2);
 }
 
 void loop()
 {
     delay(10);
-}
\ No newline at end of file
+}
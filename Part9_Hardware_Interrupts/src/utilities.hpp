@@ -1,3 +1,4 @@
+#pragma once
 #include <Arduino.h>
 
 // Swap the write_to and read_from pointers in the double buffer
@@ -0,0 +1,133 @@
+/**
+ * Fixed-memory latency histogram
+ *
+ * Records values (microseconds, cycles, ...) into 128 buckets (512 bytes):
+ * exact up to 15, then 4 buckets per power of two, so any value is off by
+ * less than 25%.
+ * record() is a few instructions and never allocates, so it can be called
+ * from timer callbacks and ISRs (one writer per histogram).
+ */
+#pragma once
+#include <Arduino.h>
+
+class LatencyHistogram
+{
+public:
+    enum
+    {
+        LINEAR = 16,  // Values below this get their own bucket
+        SUB_BITS = 2, // 4 buckets per power of two above that
+        BUCKETS = LINEAR + (32 - 4) * (1 << SUB_BITS),
+    };
+
+    LatencyHistogram()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        memset((void *)counts, 0, sizeof(counts));
+        count = 0;
+        sum = 0;
+        min = UINT32_MAX;
+        max = 0;
+    }
+
+    inline void record(uint32_t value)
+    {
+        counts[bucketOf(value)]++;
+        count++;
+        sum += value;
+        if (value < min)
+        {
+            min = value;
+        }
+        if (value > max)
+        {
+            max = value;
+        }
+    }
+
+    // Upper bound of the bucket holding the p-th percentile (0 to 100)
+    uint32_t percentile(float p) const
+    {
+        if (count == 0)
+        {
+            return 0;
+        }
+        uint32_t rank = (uint32_t)(p / 100.0f * count);
+        if (rank >= count)
+        {
+            rank = count - 1;
+        }
+        uint32_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++)
+        {
+            seen += counts[i];
+            if (seen > rank)
+            {
+                return std::min(upperBound(i), (uint32_t)max);
+            }
+        }
+        return max;
+    }
+
+    uint32_t getCount() const
+    {
+        return count;
+    }
+
+    uint32_t getMin() const
+    {
+        return count ? min : 0;
+    }
+
+    uint32_t getMax() const
+    {
+        return max;
+    }
+
+    uint32_t getMean() const
+    {
+        return count ? (uint32_t)(sum / count) : 0;
+    }
+
+    // One line: name, count, min/mean/p50/p99/max
+    void print(const char *name, const char *unit = "us") const
+    {
+        Serial.printf("%-16s n=%-7u min %6u | mean %6u | p50 %6u | p99 %6u | max %6u %s\r\n",
+                      name, count, getMin(), getMean(),
+                      percentile(50), percentile(99), getMax(), unit);
+    }
+
+private:
+    static inline int bucketOf(uint32_t value)
+    {
+        if (value < LINEAR)
+        {
+            return value;
+        }
+        int msb = 31 - __builtin_clz(value); // 4..31
+        int sub = (value >> (msb - SUB_BITS)) & ((1 << SUB_BITS) - 1);
+        return LINEAR + ((msb - 4) << SUB_BITS) + sub;
+    }
+
+    static uint32_t upperBound(int bucket)
+    {
+        if (bucket < LINEAR)
+        {
+            return bucket;
+        }
+        int msb = ((bucket - LINEAR) >> SUB_BITS) + 4;
+        int sub = (bucket - LINEAR) & ((1 << SUB_BITS) - 1);
+        uint64_t next = (uint64_t)((1 << SUB_BITS) + sub + 1) << (msb - SUB_BITS);
+        return (uint32_t)std::min(next - 1, (uint64_t)UINT32_MAX);
+    }
+
+    volatile uint32_t counts[BUCKETS];
+    volatile uint32_t count;
+    volatile uint64_t sum;
+    volatile uint32_t min;
+    volatile uint32_t max;
+};
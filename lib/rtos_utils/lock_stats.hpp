@@ -0,0 +1,472 @@
+/**
+ * Lock instrumentation: contention, time-to-acquire and hold time
+ *
+ * ProfiledLock<Lock> wraps any lock with take(timeout)/give() and records,
+ * per core:
+ *  - acquisitions, and how many of them found the lock taken (contended)
+ *  - spins: failed attempts while waiting (spinlocks only)
+ * and two histograms, per core and for each task that uses it (up to
+ * MAX_TASKS):
+ *  - wait: from calling take() to getting the lock
+ *  - hold: from getting the lock to giving it back
+ * Times are in microseconds, or CPU cycles for a SpinLock. The stats are
+ * only written while the lock is held, in fixed memory (about 6.5 KB per
+ * lock), and nothing is printed while the tasks run. LockStats::printAll()
+ * dumps every lock; LockStats::pollCommand(), called from loop(), does it
+ * when "stats" is typed and clears the stats on "reset". Clearing takes each
+ * lock, so it never splits a holder's update. Printing doesn't, so a report
+ * taken while the tasks run can be off by the update in progress.
+ *
+ *   static ProfiledLock<MutexLock> lock;
+ *   lock.begin("lock");               // Extra arguments go to Lock::begin()
+ *   lock.take(portMAX_DELAY); ... lock.give();
+ *
+ * MutexLock and SpinLock adapt a FreeRTOS mutex and a portMUX critical
+ * section; CeilingMutex can be wrapped as is. A Lock's take(0) must try once
+ * without waiting. take() and give() look up the calling task, so they are
+ * for tasks, not ISRs.
+ *
+ * Without -D LOCK_PROFILING, ProfiledLock only forwards to the Lock: nothing
+ * is recorded or registered, so the lock compiles to the same code as the
+ * bare one, and printAll() says profiling is off.
+ */
+#pragma once
+#include <Arduino.h>
+#include "latency_histogram.hpp"
+
+// FreeRTOS mutex (priority inheritance)
+class MutexLock
+{
+public:
+    bool begin()
+    {
+        handle = xSemaphoreCreateMutex();
+        return handle != NULL;
+    }
+
+    inline bool take(TickType_t timeout)
+    {
+        return xSemaphoreTake(handle, timeout) == pdTRUE;
+    }
+
+    inline void give()
+    {
+        xSemaphoreGive(handle);
+    }
+
+    SemaphoreHandle_t getHandle() const
+    {
+        return handle;
+    }
+
+private:
+    SemaphoreHandle_t handle = NULL;
+};
+
+// Critical section (spinlock, interrupts off on this core). Any timeout but
+// 0 spins until the lock is free.
+class SpinLock
+{
+public:
+    bool begin()
+    {
+        portMUX_INITIALIZE(&mux);
+        return true;
+    }
+
+    inline bool take(TickType_t timeout)
+    {
+        if (timeout == 0)
+        {
+            return portTRY_ENTER_CRITICAL(&mux, portMUX_TRY_LOCK) == pdPASS;
+        }
+        portENTER_CRITICAL(&mux);
+        return true;
+    }
+
+    inline void give()
+    {
+        portEXIT_CRITICAL(&mux);
+    }
+
+private:
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+// Locks that busy-wait: waits are counted in spins and timed in cycles
+template <typename Lock>
+struct LockTraits
+{
+    enum
+    {
+        SPINS = 0,
+    };
+};
+
+template <>
+struct LockTraits<SpinLock>
+{
+    enum
+    {
+        SPINS = 1,
+    };
+};
+
+class LockStats
+{
+public:
+    enum
+    {
+        MAX_TASKS = 4,    // Tasks per lock
+        CMD_BUF_LEN = 16, // Characters in a pollCommand() line
+    };
+
+    // Print every ProfiledLock
+    static void printAll()
+    {
+#ifdef LOCK_PROFILING
+        for (LockStats *stats = first(); stats != NULL; stats = stats->next)
+        {
+            stats->print();
+        }
+#else
+        Serial.println("Lock profiling off (build with -D LOCK_PROFILING)");
+#endif
+    }
+
+    static void resetAll()
+    {
+#ifdef LOCK_PROFILING
+        for (LockStats *stats = first(); stats != NULL; stats = stats->next)
+        {
+            stats->reset();
+        }
+#endif
+    }
+
+    // Act on one command line: "stats" prints every lock, "reset" clears
+    // them. Returns false for anything else.
+    static bool command(const char *line)
+    {
+        if (strcmp(line, "stats") == 0)
+        {
+            printAll();
+        }
+        else if (strcmp(line, "reset") == 0)
+        {
+            resetAll();
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+
+    // Read command lines from Serial without blocking (call it regularly,
+    // e.g. from loop()). serial_mutex, if the program shares Serial under
+    // one, is held while printing. It may be a profiled lock's own mutex:
+    // "reset" runs without it, as resetAll() takes every lock.
+    static void pollCommand(SemaphoreHandle_t serial_mutex = NULL)
+    {
+        static char cmd_buf[CMD_BUF_LEN];
+        static uint8_t idx = 0;
+
+        while (Serial.available() > 0)
+        {
+            char c = Serial.read();
+            if ((c == '\n') || (c == '\r'))
+            {
+                cmd_buf[idx] = '\0';
+                if (serial_mutex != NULL && strcmp(cmd_buf, "stats") == 0)
+                {
+                    xSemaphoreTake(serial_mutex, portMAX_DELAY);
+                    printAll();
+                    xSemaphoreGive(serial_mutex);
+                }
+                else if (idx > 0)
+                {
+                    command(cmd_buf);
+                }
+                idx = 0;
+            }
+            else if (idx < CMD_BUF_LEN - 1)
+            {
+                cmd_buf[idx++] = c;
+            }
+        }
+    }
+
+#ifdef LOCK_PROFILING
+    void print() const
+    {
+        Serial.printf("Lock \"%s\" (%s):\r\n", name, unit);
+        for (int core = 0; core < portNUM_PROCESSORS; core++)
+        {
+            const CoreStats &stats = cores[core];
+            if (stats.acquisitions == 0)
+            {
+                continue;
+            }
+            Serial.printf("  core %d: %u acquisitions, %u contended (%.1f%%)",
+                          core, (unsigned)stats.acquisitions, (unsigned)stats.contended,
+                          100.0f * stats.contended / stats.acquisitions);
+            if (spins)
+            {
+                Serial.printf(", %u spins", (unsigned)stats.spins);
+            }
+            Serial.print("\r\n");
+            char line[32];
+            snprintf(line, sizeof(line), "core %d wait", core);
+            stats.wait.print(line, unit);
+            snprintf(line, sizeof(line), "core %d hold", core);
+            stats.hold.print(line, unit);
+        }
+        for (int i = 0; i < MAX_TASKS; i++)
+        {
+            const Slot &slot = slots[i];
+            if (slot.task == NULL)
+            {
+                continue;
+            }
+            char line[32];
+            snprintf(line, sizeof(line), "%s wait", slot.name);
+            slot.wait.print(line, unit);
+            snprintf(line, sizeof(line), "%s hold", slot.name);
+            slot.hold.print(line, unit);
+        }
+    }
+
+    // Clear everything (ProfiledLock holds the lock while this runs)
+    virtual void reset()
+    {
+        for (int core = 0; core < portNUM_PROCESSORS; core++)
+        {
+            cores[core].acquisitions = 0;
+            cores[core].contended = 0;
+            cores[core].spins = 0;
+            cores[core].wait.reset();
+            cores[core].hold.reset();
+        }
+        for (int i = 0; i < MAX_TASKS; i++)
+        {
+            slots[i].wait.reset();
+            slots[i].hold.reset();
+        }
+    }
+
+protected:
+    struct CoreStats
+    {
+        uint32_t acquisitions = 0;
+        uint32_t contended = 0;
+        uint32_t spins = 0;
+        LatencyHistogram wait;
+        LatencyHistogram hold;
+    };
+
+    struct Slot
+    {
+        TaskHandle_t task = NULL;
+        char name[16];
+        LatencyHistogram wait;
+        LatencyHistogram hold;
+    };
+
+    void add(const char *name, bool spins)
+    {
+        this->name = name;
+        this->spins = spins;
+        unit = spins ? "cycles" : "us";
+        portENTER_CRITICAL(&registry_lock());
+        LockStats **link = &first();
+        while (*link != NULL)
+        {
+            link = &(*link)->next;
+        }
+        *link = this;
+        portEXIT_CRITICAL(&registry_lock());
+    }
+
+    // The calling task's slot, claimed on first use. NULL if the table is
+    // full (that task isn't recorded per task).
+    Slot *slotFor(TaskHandle_t task)
+    {
+        for (int i = 0; i < MAX_TASKS; i++)
+        {
+            if (slots[i].task == task)
+            {
+                return &slots[i];
+            }
+        }
+        Slot *slot = NULL;
+        portENTER_CRITICAL(&registry_lock());
+        for (int i = 0; i < MAX_TASKS && slot == NULL; i++)
+        {
+            if (slots[i].task == NULL)
+            {
+                slot = &slots[i];
+                strncpy(slot->name, pcTaskGetName(task), sizeof(slot->name) - 1);
+                slot->name[sizeof(slot->name) - 1] = '\0';
+                slot->task = task;
+            }
+        }
+        portEXIT_CRITICAL(&registry_lock());
+        return slot;
+    }
+
+    // Call with the lock just taken
+    void acquired(Slot *slot, uint32_t spin_count, bool contended, uint32_t wait)
+    {
+        holder = slot;
+        holder_core = xPortGetCoreID();
+        CoreStats &stats = cores[holder_core];
+        stats.acquisitions++;
+        if (contended)
+        {
+            stats.contended++;
+        }
+        stats.spins += spin_count;
+        stats.wait.record(wait);
+        if (slot != NULL)
+        {
+            slot->wait.record(wait);
+        }
+    }
+
+    // Call with the lock still held. Hold time goes to the core that took it.
+    void released(uint32_t hold)
+    {
+        cores[holder_core].hold.record(hold);
+        if (holder != NULL)
+        {
+            holder->hold.record(hold);
+        }
+    }
+
+    CoreStats cores[portNUM_PROCESSORS];
+    Slot slots[MAX_TASKS];
+    Slot *holder = NULL; // Slot of the task holding the lock
+    int holder_core = 0;
+    uint32_t taken = 0; // Clock when the holder got the lock
+
+private:
+    static LockStats *&first()
+    {
+        static LockStats *head = NULL;
+        return head;
+    }
+
+    static portMUX_TYPE &registry_lock()
+    {
+        static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+        return lock;
+    }
+
+    const char *name = "";
+    const char *unit = "";
+    bool spins = false;
+    LockStats *next = NULL;
+#endif
+};
+
+#ifdef LOCK_PROFILING
+
+template <typename Lock>
+class ProfiledLock : public LockStats
+{
+public:
+    template <typename... Args>
+    bool begin(const char *name, Args... args)
+    {
+        add(name, LockTraits<Lock>::SPINS);
+        return lock.begin(args...);
+    }
+
+    bool take(TickType_t timeout)
+    {
+        Slot *slot = slotFor(xTaskGetCurrentTaskHandle());
+        uint32_t start = now();
+        uint32_t spin_count = 0;
+        bool contended = !lock.take(0);
+        if (contended)
+        {
+            if (LockTraits<Lock>::SPINS)
+            {
+                // Interrupts are back on between attempts
+                while (!lock.take(0))
+                {
+                    spin_count++;
+                }
+            }
+            else if (timeout == 0 || !lock.take(timeout))
+            {
+                return false;
+            }
+        }
+        taken = now();
+        acquired(slot, spin_count, contended, taken - start);
+        return true;
+    }
+
+    void give()
+    {
+        released(now() - taken);
+        lock.give();
+    }
+
+    // Clear under the lock, so no holder is halfway through its update.
+    // Taken directly: the reset isn't recorded.
+    void reset() override
+    {
+        lock.take(portMAX_DELAY);
+        LockStats::reset();
+        lock.give();
+    }
+
+    Lock &get()
+    {
+        return lock;
+    }
+
+private:
+    static inline uint32_t now()
+    {
+        return LockTraits<Lock>::SPINS ? ESP.getCycleCount() : (uint32_t)esp_timer_get_time();
+    }
+
+    Lock lock;
+};
+
+#else
+
+template <typename Lock>
+class ProfiledLock
+{
+public:
+    template <typename... Args>
+    bool begin(const char *name, Args... args)
+    {
+        return lock.begin(args...);
+    }
+
+    inline bool take(TickType_t timeout)
+    {
+        return lock.take(timeout);
+    }
+
+    inline void give()
+    {
+        lock.give();
+    }
+
+    Lock &get()
+    {
+        return lock;
+    }
+
+private:
+    Lock lock;
+};
+
+#endif
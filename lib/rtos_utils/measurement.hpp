@@ -0,0 +1,45 @@
+/**
+ * ADC block measurement
+ *
+ * Everything the processing task learns from one sample block, published as
+ * one Snapshot<Measurement> so readers never see e.g. the mean of one block
+ * with the RMS of the next.
+ */
+#pragma once
+#include <Arduino.h>
+
+struct Measurement
+{
+    float mean;            // Average in ADC counts
+    float rms;             // RMS around the mean (DC removed), in ADC counts
+    uint16_t min;          // Smallest sample in the block
+    uint16_t max;          // Largest sample in the block
+    uint32_t seq;          // Block sequence number (0 = nothing measured yet)
+    uint32_t timestamp_us; // micros() when the block was processed
+};
+
+inline Measurement measureBlock(const uint16_t *buf, int len, uint32_t seq)
+{
+    Measurement m;
+    float sum = 0.0;
+    m.min = UINT16_MAX;
+    m.max = 0;
+    for (int i = 0; i < len; i++)
+    {
+        sum += (float)buf[i];
+        m.min = std::min(m.min, buf[i]);
+        m.max = std::max(m.max, buf[i]);
+    }
+    m.mean = sum / len;
+
+    float sq_sum = 0.0;
+    for (int i = 0; i < len; i++)
+    {
+        float diff = (float)buf[i] - m.mean;
+        sq_sum += diff * diff;
+    }
+    m.rms = sqrtf(sq_sum / len);
+    m.seq = seq;
+    m.timestamp_us = micros();
+    return m;
+}
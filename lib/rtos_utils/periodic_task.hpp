@@ -0,0 +1,112 @@
+/**
+ * Drift-free periodic loop with deadline and release-jitter monitoring
+ *
+ * vTaskDelay(period) sleeps *after* the work, so every iteration is late by
+ * the time the work took and the loop drifts. PeriodicTask keeps absolute
+ * release times (vTaskDelayUntil) instead:
+ *
+ *   static PeriodicTask blink;                  // Static: holds a histogram
+ *
+ *   blink.begin(500 / portTICK_PERIOD_MS);
+ *   while (1)
+ *   {
+ *       ... work ...
+ *       blink.wait();                           // was vTaskDelay(500 / ...)
+ *   }
+ *
+ * wait(ticks) uses a different interval for the next release, e.g. separate
+ * on and off times; an interval of 0 is taken as 1 tick. Each wait() checks
+ * that the work finished within the deadline (the interval, unless one is
+ * given to begin()) and counts an overrun if not. It also records how late
+ * the task actually woke up after each release (release jitter, in
+ * microseconds). print() reports both.
+ */
+#pragma once
+#include <Arduino.h>
+#include "latency_histogram.hpp"
+
+class PeriodicTask
+{
+public:
+    // Start the schedule now. deadline: ticks after each release, 0 for the
+    // interval to the next release.
+    void begin(TickType_t period, TickType_t deadline = 0)
+    {
+        this->period = period;
+        this->deadline = deadline;
+        overruns = 0;
+        releases = 0;
+        jitter.reset();
+
+        // Start on a tick edge so that tick and esp_timer times line up
+        vTaskDelay(1);
+        base_tick = xTaskGetTickCount();
+        base_us = esp_timer_get_time();
+        wake = base_tick;
+        release_us = base_us;
+    }
+
+    // End of the current job: sleep until the next release. Returns false if
+    // the job overran its deadline.
+    bool wait()
+    {
+        return wait(period);
+    }
+
+    bool wait(TickType_t interval)
+    {
+        // vTaskDelayUntil() asserts on a 0 increment
+        if (interval == 0)
+        {
+            interval = 1;
+        }
+        TickType_t limit = deadline != 0 ? deadline : interval;
+        bool met = esp_timer_get_time() - release_us <= (int64_t)limit * portTICK_PERIOD_MS * 1000;
+        if (!met)
+        {
+            overruns++;
+        }
+
+        vTaskDelayUntil(&wake, interval);
+        release_us = base_us + (int64_t)(TickType_t)(wake - base_tick) * portTICK_PERIOD_MS * 1000;
+        // The base time was read just after a wake, so a quicker wake can
+        // look early: count that as on time
+        int64_t late = esp_timer_get_time() - release_us;
+        jitter.record(late > 0 ? (uint32_t)late : 0);
+        releases++;
+        return met;
+    }
+
+    uint32_t getOverruns() const
+    {
+        return overruns;
+    }
+
+    uint32_t getReleases() const
+    {
+        return releases;
+    }
+
+    const LatencyHistogram &getJitter() const
+    {
+        return jitter;
+    }
+
+    // Jitter histogram and overruns
+    void print(const char *name) const
+    {
+        jitter.print(name);
+        Serial.printf("  %u releases, %u overruns\r\n", (unsigned)releases, (unsigned)overruns);
+    }
+
+private:
+    TickType_t period = 1;
+    TickType_t deadline = 0;
+    TickType_t wake = 0;
+    TickType_t base_tick = 0;
+    int64_t base_us = 0;
+    int64_t release_us = 0;
+    volatile uint32_t overruns = 0;
+    volatile uint32_t releases = 0;
+    LatencyHistogram jitter;
+};
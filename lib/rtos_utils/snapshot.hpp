@@ -0,0 +1,115 @@
+/**
+ * Versioned snapshot for publishing a struct to many readers
+ *
+ * A writer publishes a whole struct at once and readers take a consistent
+ * copy without locks or kernel calls (a double-buffered seqlock):
+ *  - the writer fills the copy readers are NOT using, then bumps the version,
+ *    which also flips which copy is current
+ *  - a reader copies the current buffer and retries if the version changed
+ *    meanwhile
+ *
+ * Because the writer never touches the buffer readers are on, a writer that
+ * gets preempted halfway through (e.g. by a higher priority reader on the
+ * same core) can't make readers spin. A reader only retries when a publish
+ * completed during its copy.
+ *
+ * Writers are serialized with a mutex created in begin(), so publish() must
+ * be called from a task. read() may be called from anywhere, ISRs included.
+ */
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <type_traits>
+
+template <typename T>
+class Snapshot
+{
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+public:
+    explicit Snapshot(const T &initial = T())
+    {
+        store(0, initial);
+    }
+
+    // Create the writer mutex (call once before publishing)
+    bool begin()
+    {
+        writer_lock = xSemaphoreCreateMutex();
+        return writer_lock != NULL;
+    }
+
+    // Make value visible to readers as one unit
+    void publish(const T &value)
+    {
+        if (writer_lock != NULL)
+        {
+            xSemaphoreTake(writer_lock, portMAX_DELAY);
+        }
+
+        // The fence keeps the buffer writes after the previous version bump,
+        // so a reader still on this buffer is guaranteed to see it changed
+        uint32_t ver = version.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        store((ver + 1) & 1, value);
+        version.store(ver + 1, std::memory_order_release);
+
+        if (writer_lock != NULL)
+        {
+            xSemaphoreGive(writer_lock);
+        }
+    }
+
+    // Consistent copy of the latest published value
+    T read() const
+    {
+        T value;
+        uint32_t before, after;
+        do
+        {
+            before = version.load(std::memory_order_acquire);
+            load(before & 1, value);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = version.load(std::memory_order_relaxed);
+        } while (before != after);
+        return value;
+    }
+
+    // Number of publishes so far (cheap way for a reader to spot a change)
+    uint32_t getVersion() const
+    {
+        return version.load(std::memory_order_acquire);
+    }
+
+private:
+    enum
+    {
+        WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t)
+    };
+
+    // Word-wise relaxed atomics: the same plain loads/stores on the ESP32,
+    // but no data race as far as the compiler is concerned
+    void store(uint32_t idx, const T &value)
+    {
+        uint32_t words[WORDS] = {0};
+        memcpy(words, &value, sizeof(T));
+        for (uint32_t i = 0; i < WORDS; i++)
+        {
+            buf[idx][i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+
+    void load(uint32_t idx, T &value) const
+    {
+        uint32_t words[WORDS];
+        for (uint32_t i = 0; i < WORDS; i++)
+        {
+            words[i] = buf[idx][i].load(std::memory_order_relaxed);
+        }
+        memcpy(&value, words, sizeof(T));
+    }
+
+    std::atomic<uint32_t> buf[2][WORDS];
+    std::atomic<uint32_t> version{0};
+    SemaphoreHandle_t writer_lock = NULL;
+};
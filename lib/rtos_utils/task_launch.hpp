@@ -0,0 +1,121 @@
+/**
+ * Typed task launch
+ *
+ * xTaskCreatePinnedToCore() only takes a void pointer, so the demos pass the
+ * address of a local (&i, &delay_arg) and then block on a binary semaphore
+ * until the new task has copied it. That serializes task creation: one
+ * context switch round-trip per task.
+ *
+ * LAUNCH_TASK() copies the argument at creation time instead, so the caller
+ * can spawn N tasks back-to-back and reuse its loop variable straight away:
+ *
+ *   void producer(int num) { ... }    // return instead of vTaskDelete(NULL)
+ *   LAUNCH_TASK(producer, i, "Producer", 1024, 1, NULL, app_cpu);
+ *
+ * Arguments that fit in a pointer (int, uint32_t, small enums, ...) travel
+ * inside the void pointer itself, so nothing is allocated. Bigger arguments
+ * (e.g. a Message struct) are copied into a heap block owned by the task and
+ * freed when the task function returns. The task function must return rather
+ * than delete itself, otherwise that block is leaked.
+ */
+#pragma once
+#include <Arduino.h>
+#include <new>
+#include <type_traits>
+
+// Start task fn(arg) and return the xTaskCreatePinnedToCore() result. The
+// argument type is taken from the variable passed in, and must match the
+// parameter type of fn.
+#define LAUNCH_TASK(fn, arg, name, stack_size, priority, handle, core) \
+    launchTask<decltype(arg), fn>(arg, name, stack_size, priority, handle, core)
+
+// Can the argument be stored inside the void pointer passed to the task?
+template <typename T>
+struct InlineTaskArg
+{
+    enum
+    {
+        value = (sizeof(T) <= sizeof(void *)) && std::is_trivially_copyable<T>::value
+    };
+};
+
+// Task-owned copy of an argument that doesn't fit in a pointer
+template <typename T>
+struct TaskArgBlock
+{
+    T arg;
+};
+
+// Each (function, type) pair gets its own entry point, so the function
+// pointer doesn't need to be stored anywhere
+template <typename T, void (*Fn)(T)>
+void inlineArgTask(void *parameters)
+{
+    T arg;
+    memcpy(&arg, &parameters, sizeof(T));
+    Fn(arg);
+    vTaskDelete(NULL);
+}
+
+template <typename T, void (*Fn)(T)>
+void heapArgTask(void *parameters)
+{
+    TaskArgBlock<T> *block = (TaskArgBlock<T> *)parameters;
+    Fn(block->arg);
+    block->~TaskArgBlock<T>();
+    vPortFree(block);
+    vTaskDelete(NULL);
+}
+
+// Small, trivially copyable argument: no allocation, no handshake
+template <typename T, void (*Fn)(T)>
+inline typename std::enable_if<InlineTaskArg<T>::value, BaseType_t>::type
+launchTask(const T &arg,
+           const char *name,
+           uint32_t stack_size,
+           UBaseType_t priority,
+           TaskHandle_t *handle,
+           BaseType_t core)
+{
+    void *parameters = NULL;
+    memcpy(&parameters, &arg, sizeof(T));
+    return xTaskCreatePinnedToCore(inlineArgTask<T, Fn>,
+                                   name,
+                                   stack_size,
+                                   parameters,
+                                   priority,
+                                   handle,
+                                   core);
+}
+
+// Any other copyable argument: copied into a heap block the task frees
+template <typename T, void (*Fn)(T)>
+inline typename std::enable_if<!InlineTaskArg<T>::value, BaseType_t>::type
+launchTask(const T &arg,
+           const char *name,
+           uint32_t stack_size,
+           UBaseType_t priority,
+           TaskHandle_t *handle,
+           BaseType_t core)
+{
+    void *mem = pvPortMalloc(sizeof(TaskArgBlock<T>));
+    if (mem == NULL)
+    {
+        return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+    }
+    TaskArgBlock<T> *block = new (mem) TaskArgBlock<T>{arg};
+
+    BaseType_t ret = xTaskCreatePinnedToCore(heapArgTask<T, Fn>,
+                                             name,
+                                             stack_size,
+                                             block,
+                                             priority,
+                                             handle,
+                                             core);
+    if (ret != pdPASS)
+    {
+        block->~TaskArgBlock<T>();
+        vPortFree(block);
+    }
+    return ret;
+}